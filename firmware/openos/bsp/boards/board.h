@@ -32,8 +32,20 @@ typedef enum {
 
 //=========================== prototypes ======================================
 
+/**
+\brief Boards which can sleep until the next opentimers deadline define
+BOARD_HAS_SLEEPFOR in their board_info.h and implement board_sleepFor().
+
+board_sleepFor() programs a wake-up at most maxTicks bsp_timer ticks away, and
+returns the number of ticks the bsp_timer did not count while asleep. Other
+boards idle in board_sleep().
+*/
+
 void board_init();
 void board_sleep();
+#ifdef BOARD_HAS_SLEEPFOR
+uint32_t board_sleepFor(uint32_t maxTicks);
+#endif
 void board_reset();
 
 #endif
@@ -21,6 +21,11 @@
 #define ENABLE_INTERRUPTS()                 ;
 #define DISABLE_INTERRUPTS()                ;
 
+//===== uart
+
+// uart_writeBuffer() hands a whole buffer to the simulator
+#define UART_HAS_WRITEBUFFER
+
 //===== timer
 
 #define PORT_TIMER_WIDTH                    uint16_t
@@ -12,6 +12,9 @@
 
 //=========================== define ==========================================
 
+/// maximum number of bytes in one OPENSIM_CMD_uart_writeBuffer request
+#define OPENSIM_UART_MAXBUFFERLEN 256
+
 //=========================== enums ===========================================
 
 typedef enum {
@@ -109,6 +112,7 @@ typedef enum {
    OPENSIM_CMD_uart_clearTxInterrupts       = 78,
    OPENSIM_CMD_uart_writeByte               = 79,
    OPENSIM_CMD_uart_readByte                = 80,
+   OPENSIM_CMD_uart_writeBuffer             = 81,
    // supply
    //===== from server to client
    // board
@@ -308,6 +312,11 @@ typedef struct {
 typedef struct {
    uint8_t byteRead;
 } opensim_repl_uart_readByte_t;
+// writeBuffer
+typedef struct {
+   uint16_t len;
+   uint8_t  buf[OPENSIM_UART_MAXBUFFERLEN];
+} opensim_requ_uart_writeBuffer_t;
 
 //--------------------------- from client to server ---------------------------
 
@@ -103,6 +103,30 @@ void uart_writeByte(uint8_t byteToWrite) {
    */
 }
 
+void uart_writeBuffer(uint8_t* buf, uint16_t len) {
+   /*
+   opensim_requ_uart_writeBuffer_t requparams;
+   uint16_t                        chunk;
+   
+   while (len>0) {
+      // prepare params
+      chunk = len<OPENSIM_UART_MAXBUFFERLEN ? len : OPENSIM_UART_MAXBUFFERLEN;
+      requparams.len = chunk;
+      memcpy(requparams.buf,buf,chunk);
+      
+      // send request to server and get reply
+      opensim_client_sendAndWaitForAck(OPENSIM_CMD_uart_writeBuffer,
+                                       &requparams,
+                                       sizeof(opensim_requ_uart_writeBuffer_t),
+                                       0,
+                                       0);
+      buf += chunk;
+      len -= chunk;
+   }
+   // the server then sends OPENSIM_CMD_uart_isr_tx
+   */
+}
+
 uint8_t uart_readByte() {
    /*
    opensim_repl_uart_readByte_t replparams;
@@ -21,6 +21,16 @@
 #define ENABLE_INTERRUPTS()                 ;
 #define DISABLE_INTERRUPTS()                ;
 
+//===== uart
+
+// uart_writeBuffer() hands a whole buffer to the simulator
+#define UART_HAS_WRITEBUFFER
+
+//===== sleep
+
+// board_sleepFor() sleeps until the next opentimers deadline
+#define BOARD_HAS_SLEEPFOR
+
 //===== timer
 
 #define PORT_TIMER_WIDTH                    uint16_t
@@ -15,6 +15,15 @@
 #include "radiotimer_obj.h"
 #include "eui64_obj.h"
 
+//=========================== defines =========================================
+
+enum {
+   NATIVE_WAKEUP_NONE             = 0,
+   NATIVE_WAKEUP_UART_TX,
+   NATIVE_WAKEUP_UART_RX,
+   NATIVE_WAKEUP_TIMER,
+};
+
 //=========================== variables =======================================
 
 //=========================== prototypes ======================================
@@ -36,13 +45,19 @@ void board_init(OpenMote* self) {
    radio_init(self);
    radiotimer_init(self);
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_board_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] board_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -56,17 +71,73 @@ void board_sleep(OpenMote* self) {
    printf("C@0x%x: board_sleep()... \n",self);
 #endif
    
+   // the mote sleeps, and runs its tasks, without the GIL
+   mote_releaseGil(self);
+   
+   if (self->native.enabled) {
+      board_nativeSleep(self);
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_board_sleep)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleep],NULL);
    if (result == NULL) {
       printf("[CRITICAL] board_sleep() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: ...done.\n",self);
+#endif
+}
+
+/**
+\brief Sleep until an interrupt, or for at most maxTicks bsp_timer ticks.
+
+If Python subscribed to board_sleepFor, it emulates a sleep mode in which the
+bsp_timer stops, and returns how long the mote slept. Otherwise, and with the
+native BSP, whose bsp_timer never stops, this falls back to board_sleep().
+
+\returns The number of ticks the bsp_timer did not count.
+*/
+uint32_t board_sleepFor(OpenMote* self, uint32_t maxTicks) {
+   PyObject*   result;
+   PyObject*   arglist;
+   uint32_t    returnVal;
+   
+   if (self->native.enabled || !mote_isSubscribed(self,MOTE_NOTIF_board_sleepFor)) {
+      board_sleep(self);
+      return 0;
+   }
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: board_sleepFor(maxTicks=%u)... \n",self,maxTicks);
+#endif
+   
+   // forward to Python
+   arglist    = Py_BuildValue("(k)",(unsigned long)maxTicks);
+   result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleepFor],arglist);
+   Py_DECREF(arglist);
+   if (result == NULL) {
+      printf("[CRITICAL] board_sleepFor() returned NULL\r\n");
+      mote_notifyDone(self);
+      return 0;
+   }
+   returnVal  = (uint32_t)PyInt_AsUnsignedLongMask(result);
+   Py_DECREF(result);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
 #endif
+   
+   mote_notifyDone(self);
+   return returnVal;
 }
 
 void board_reset(OpenMote* self) {
@@ -76,17 +147,96 @@ void board_reset(OpenMote* self) {
    printf("C@0x%x: board_reset()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_board_reset)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_reset],NULL);
    if (result == NULL) {
       printf("[CRITICAL] board_reset() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
 #endif
 }
 
+/**
+\brief Switch to the native BSP, see OpenMote.set_native().
+
+\param[in] baudrate The baudrate of the native UART, 10 bits per byte.
+*/
+void board_nativeInit(OpenMote* self, uint32_t baudrate) {
+   memset(&self->native,0,sizeof(native_bsp_t));
+   self->native.enabled      = TRUE;
+   self->native.uartByteTime = (uint32_t)(((uint64_t)10*NATIVE_TICKS_PER_S<<NATIVE_SUBTICK_SHIFT)/baudrate);
+}
+
+/**
+\brief Sleep until the next interrupt of the native BSP, and handle it.
+
+The native clock jumps to the earliest of the bsp_timer compare, the end of the
+UART transmission and the arrival of the next UART byte; on a tie, the UART
+goes first.
+*/
+void board_nativeSleep(OpenMote* self) {
+   uint64_t    wakeUpTime;
+   uint8_t     wakeUp;
+   
+   wakeUp     = NATIVE_WAKEUP_NONE;
+   wakeUpTime = 0;
+   if (self->native.uartTxBusy) {
+      wakeUp     = NATIVE_WAKEUP_UART_TX;
+      wakeUpTime = self->native.uartTxDoneTime;
+   }
+   if (
+         self->native.uartRxIdxW!=self->native.uartRxIdxR &&
+         (wakeUp==NATIVE_WAKEUP_NONE || self->native.uartRxNextTime<wakeUpTime)
+      ) {
+      wakeUp     = NATIVE_WAKEUP_UART_RX;
+      wakeUpTime = self->native.uartRxNextTime;
+   }
+   if (
+         self->native.timerArmed &&
+         (wakeUp==NATIVE_WAKEUP_NONE || self->native.timerFireTime<wakeUpTime)
+      ) {
+      wakeUp     = NATIVE_WAKEUP_TIMER;
+      wakeUpTime = self->native.timerFireTime;
+   }
+   
+   if (wakeUp==NATIVE_WAKEUP_NONE) {
+      // nothing will ever wake the mote up
+      if (self->native.numStuckSleeps==0) {
+         printf("[CRITICAL] board_sleep() with no interrupt pending\r\n");
+      }
+      self->native.numStuckSleeps++;
+      return;
+   }
+   if (wakeUpTime>self->native.now) {
+      self->native.now = wakeUpTime;
+   }
+   
+   switch (wakeUp) {
+      case NATIVE_WAKEUP_UART_TX:
+         self->native.uartTxBusy  = FALSE;
+         uart_intr_tx(self);
+         break;
+      case NATIVE_WAKEUP_UART_RX:
+         self->native.uartRxByte  = self->native.uartRxBuf[self->native.uartRxIdxR&(NATIVE_UART_RX_SIZE-1)];
+         self->native.uartRxIdxR++;
+         self->native.uartRxNextTime += self->native.uartByteTime;
+         uart_intr_rx(self);
+         break;
+      case NATIVE_WAKEUP_TIMER:
+         self->native.timerArmed  = FALSE;
+         bsp_timer_isr(self);
+         break;
+   }
+}
+
 //=========================== private =========================================
@@ -28,13 +28,25 @@ void bsp_timer_init(OpenMote* self) {
    printf("C@0x%x: bsp_timer_init()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.timerResetTime   = self->native.now;
+      self->native.timerLastCompare = 0;
+      self->native.timerArmed       = FALSE;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_bsp_timer_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] bsp_timer_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -48,13 +60,25 @@ void bsp_timer_reset(OpenMote* self) {
    printf("C@0x%x: bsp_timer_reset()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.timerResetTime   = self->native.now;
+      self->native.timerLastCompare = 0;
+      self->native.timerArmed       = FALSE;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_bsp_timer_reset)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_reset],NULL);
    if (result == NULL) {
       printf("[CRITICAL] bsp_timer_reset() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -62,22 +86,45 @@ void bsp_timer_reset(OpenMote* self) {
 }
 
 void bsp_timer_scheduleIn(OpenMote* self, PORT_TIMER_WIDTH delayTicks) {
-   PyObject*   result;
-   PyObject*   arglist;
+   PyObject*        result;
+   PyObject*        arglist;
+   PORT_TIMER_WIDTH counter;
+   PORT_TIMER_WIDTH elapsed;
    
 #ifdef TRACE_ON
    printf("C@0x%x: bsp_timer_scheduleIn(delayTicks=%d)... \n",self,delayTicks);
 #endif
    
+   if (self->native.enabled) {
+      // as on real boards, relative to the previous compare
+      counter    = bsp_timer_nativeCounter(self);
+      elapsed    = counter-self->native.timerLastCompare;
+      self->native.timerLastCompare += delayTicks;
+      self->native.timerArmed        = TRUE;
+      if (delayTicks<=elapsed) {
+         // too late, fires right away
+         self->native.timerFireTime  = self->native.now;
+      } else {
+         self->native.timerFireTime  = self->native.now+
+            ((uint64_t)(PORT_TIMER_WIDTH)(self->native.timerLastCompare-counter)<<NATIVE_SUBTICK_SHIFT);
+      }
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_bsp_timer_scheduleIn)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",delayTicks);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_scheduleIn],arglist);
    if (result == NULL) {
       printf("[CRITICAL] bsp_timer_scheduleIn() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -91,13 +138,23 @@ void bsp_timer_cancel_schedule(OpenMote* self) {
    printf("C@0x%x: bsp_timer_cancel_schedule()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.timerArmed       = FALSE;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_bsp_timer_cancel_schedule)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_cancel_schedule],NULL);
    if (result == NULL) {
       printf("[CRITICAL] bsp_timer_cancel_schedule() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -112,10 +169,19 @@ PORT_TIMER_WIDTH bsp_timer_get_currentValue(OpenMote* self) {
    printf("C@0x%x: bsp_timer_get_currentValue()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return bsp_timer_nativeCounter(self);
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_bsp_timer_get_currentValue)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_get_currentValue],NULL);
    if (result == NULL) {
       printf("[CRITICAL] bsp_timer_get_currentValue() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal  = (PORT_TIMER_WIDTH)PyInt_AsLong(result);
@@ -125,8 +191,17 @@ PORT_TIMER_WIDTH bsp_timer_get_currentValue(OpenMote* self) {
    printf("returnVal=%d.\n",returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
+
+/**
+\brief The counter of the native bsp_timer, see OpenMote.set_native().
+*/
+PORT_TIMER_WIDTH bsp_timer_nativeCounter(OpenMote* self) {
+   return (PORT_TIMER_WIDTH)((self->native.now-self->native.timerResetTime)>>NATIVE_SUBTICK_SHIFT);
+}
+
 //=========================== private =========================================
 
 //=========================== interrupt handlers ==============================
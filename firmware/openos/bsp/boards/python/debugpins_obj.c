@@ -21,13 +21,23 @@ void debugpins_init(OpenMote* self) {
    printf("C@0x%x: debugpins_init()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins  = 0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -41,13 +51,27 @@ void debugpins_frame_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_FRAME;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_frame_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_frame_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_frame_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -60,13 +84,27 @@ void debugpins_frame_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_FRAME;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_frame_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_frame_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_frame_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -79,13 +117,27 @@ void debugpins_frame_set(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_FRAME;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_frame_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_frame_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_frame_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -99,13 +151,27 @@ void debugpins_slot_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_SLOT;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_slot_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_slot_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_slot_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -118,13 +184,27 @@ void debugpins_slot_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_SLOT;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_slot_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_slot_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_slot_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -137,13 +217,27 @@ void debugpins_slot_set(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_SLOT;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_slot_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_slot_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_slot_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -157,13 +251,27 @@ void debugpins_fsm_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_FSM;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_fsm_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_fsm_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_fsm_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -176,13 +284,27 @@ void debugpins_fsm_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_FSM;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_fsm_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_fsm_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_fsm_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -195,13 +317,27 @@ void debugpins_fsm_set(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_FSM;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_fsm_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_fsm_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_fsm_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -215,13 +351,27 @@ void debugpins_task_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_task_toggle(... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_TASK;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_task_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_task_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_task_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -234,13 +384,27 @@ void debugpins_task_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_task_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_TASK;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_task_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_task_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_task_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -253,13 +417,27 @@ void debugpins_task_set(OpenMote* self) {
    printf("C@0x%x: debugpins_task_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_TASK;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_task_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_task_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_task_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -273,13 +451,27 @@ void debugpins_isr_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_ISR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_isr_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_isr_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_isr_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -292,13 +484,27 @@ void debugpins_isr_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_ISR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_isr_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_isr_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_isr_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -311,13 +517,27 @@ void debugpins_isr_set(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_ISR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_isr_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_isr_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_isr_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -331,13 +551,27 @@ void debugpins_radio_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins ^=  NATIVE_DEBUGPIN_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_radio_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_radio_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_radio_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -350,13 +584,27 @@ void debugpins_radio_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_clr()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins &= ~NATIVE_DEBUGPIN_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_radio_clr,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_radio_clr)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_clr],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_radio_clr() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -369,13 +617,27 @@ void debugpins_radio_set(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_set()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.debugpins |=  NATIVE_DEBUGPIN_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_debugpins_radio_set,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_debugpins_radio_set)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_set],NULL);
    if (result == NULL) {
       printf("[CRITICAL] debugpins_radio_set() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
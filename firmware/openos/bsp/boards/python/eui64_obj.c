@@ -23,20 +23,27 @@ void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
    printf("C@0x%x: eui64_get()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_eui64_get)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_eui64_get],NULL);
    if (result == NULL) {
       printf("[CRITICAL] eui64_get() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    
    // verify
    if (!PySequence_Check(result)) {
       printf("[CRITICAL] eui64_get() did not return a list\r\n");
+      mote_notifyDone(self);
       return;
    }
    if (PyList_Size(result)!=8) {
       printf("[CRITICAL] eui64_get() did not return a list of exactly 8 elements\r\n");
+      mote_notifyDone(self);
       return;
    }
 
@@ -57,6 +64,7 @@ void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
    
    // dispose of returned value
    Py_DECREF(result);
+   mote_notifyDone(self);
 }
 
 //=========================== private =========================================
\ No newline at end of file
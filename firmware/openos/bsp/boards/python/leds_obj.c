@@ -22,13 +22,23 @@ void leds_init(OpenMote* self) {
    printf("C@0x%x: leds_init()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds     = 0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -42,13 +52,27 @@ void leds_error_on(OpenMote* self) {
    printf("C@0x%x: leds_error_on()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    |=  NATIVE_LED_ERROR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_error_on,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_error_on)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_on],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_error_on() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -61,13 +85,27 @@ void leds_error_off(OpenMote* self) {
    printf("C@0x%x: leds_error_off()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    &= ~NATIVE_LED_ERROR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_error_off,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_error_off)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_off],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_error_off() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -80,13 +118,27 @@ void leds_error_toggle(OpenMote* self) {
    printf("C@0x%x: leds_error_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    ^=  NATIVE_LED_ERROR;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_error_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_error_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_error_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -100,10 +152,19 @@ uint8_t leds_error_isOn(OpenMote* self) {
    printf("C@0x%x: leds_error_isOn()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return (self->native.leds&NATIVE_LED_ERROR)!=0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_error_isOn)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_isOn],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_error_isOn() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = (uint8_t)PyInt_AsLong(result);
@@ -113,6 +174,7 @@ uint8_t leds_error_isOn(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 void leds_error_blink(OpenMote* self) {
@@ -122,13 +184,23 @@ void leds_error_blink(OpenMote* self) {
    printf("C@0x%x: leds_error_blink()... \n",self);
 #endif
    
+   if (mote_logEvent(self,MOTE_NOTIF_leds_error_blink,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_error_blink)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_blink],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_error_blink() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -142,13 +214,27 @@ void leds_radio_on(OpenMote* self) {
    printf("C@0x%x: leds_radio_on()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    |=  NATIVE_LED_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_radio_on,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_radio_on)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_on],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_radio_on() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -161,13 +247,27 @@ void leds_radio_off(OpenMote* self) {
    printf("C@0x%x: leds_radio_off()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    &= ~NATIVE_LED_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_radio_off,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_radio_off)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_off],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_radio_off() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -180,13 +280,27 @@ void leds_radio_toggle(OpenMote* self) {
    printf("C@0x%x: leds_radio_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    ^=  NATIVE_LED_RADIO;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_radio_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_radio_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_radio_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -200,10 +314,19 @@ uint8_t leds_radio_isOn(OpenMote* self) {
    printf("C@0x%x: leds_radio_isOn()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return (self->native.leds&NATIVE_LED_RADIO)!=0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_radio_isOn)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_isOn],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_radio_isOn() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = (uint8_t)PyInt_AsLong(result);
@@ -213,6 +336,7 @@ uint8_t leds_radio_isOn(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -224,13 +348,27 @@ void leds_sync_on(OpenMote* self) {
    printf("C@0x%x: leds_sync_on()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    |=  NATIVE_LED_SYNC;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_sync_on,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_sync_on)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_on],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_sync_on() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -243,13 +381,27 @@ void leds_sync_off(OpenMote* self) {
    printf("C@0x%x: leds_sync_off()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    &= ~NATIVE_LED_SYNC;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_sync_off,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_sync_off)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_off],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_sync_off() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -262,13 +414,27 @@ void leds_sync_toggle(OpenMote* self) {
    printf("C@0x%x: leds_sync_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    ^=  NATIVE_LED_SYNC;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_sync_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_sync_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_sync_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -282,10 +448,19 @@ uint8_t leds_sync_isOn(OpenMote* self) {
    printf("C@0x%x: leds_sync_isOn()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return (self->native.leds&NATIVE_LED_SYNC)!=0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_sync_isOn)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_isOn],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_sync_isOn() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = (uint8_t)PyInt_AsLong(result);
@@ -295,6 +470,7 @@ uint8_t leds_sync_isOn(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -306,13 +482,27 @@ void leds_debug_on(OpenMote* self) {
    printf("C@0x%x: leds_debug_on()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    |=  NATIVE_LED_DEBUG;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_debug_on,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_debug_on)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_on],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_debug_on() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -325,13 +515,27 @@ void leds_debug_off(OpenMote* self) {
    printf("C@0x%x: leds_debug_off()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    &= ~NATIVE_LED_DEBUG;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_debug_off,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_debug_off)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_off],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_debug_off() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -344,13 +548,27 @@ void leds_debug_toggle(OpenMote* self) {
    printf("C@0x%x: leds_debug_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    ^=  NATIVE_LED_DEBUG;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_debug_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_debug_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_toggle],NULL);
     if (result == NULL) {
       printf("[CRITICAL] leds_debug_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -364,10 +582,19 @@ uint8_t leds_debug_isOn(OpenMote* self) {
    printf("C@0x%x: leds_debug_isOn()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return (self->native.leds&NATIVE_LED_DEBUG)!=0;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_debug_isOn)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_isOn],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_debug_isOn() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = (uint8_t)PyInt_AsLong(result);
@@ -377,6 +604,7 @@ uint8_t leds_debug_isOn(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -387,13 +615,27 @@ void leds_all_on(OpenMote* self) {
    printf("C@0x%x: leds_all_on()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    |=  NATIVE_LED_ALL;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_all_on,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_all_on)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_on],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_all_on() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -406,13 +648,27 @@ void leds_all_off(OpenMote* self) {
    printf("C@0x%x: leds_all_off()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    &= ~NATIVE_LED_ALL;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_all_off,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_all_off)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_off],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_all_off() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -425,13 +681,27 @@ void leds_all_toggle(OpenMote* self) {
    printf("C@0x%x: leds_all_toggle()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.leds    ^=  NATIVE_LED_ALL;
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_all_toggle,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_all_toggle)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_toggle],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_all_toggle() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -445,13 +715,31 @@ void leds_circular_shift(OpenMote* self) {
    printf("C@0x%x: leds_circular_shift()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      if (self->native.leds==0) {
+         self->native.leds  = NATIVE_LED_ERROR;
+      } else {
+         self->native.leds  = ((self->native.leds<<1)|(self->native.leds>>3))&NATIVE_LED_ALL;
+      }
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_circular_shift,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_circular_shift)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_circular_shift],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_circular_shift() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -465,13 +753,31 @@ void leds_increment(OpenMote* self) {
    printf("C@0x%x: leds_increment()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      if (self->native.leds==0) {
+         self->native.leds  = NATIVE_LED_ERROR;
+      } else {
+         self->native.leds  = (self->native.leds+1)&NATIVE_LED_ALL;
+      }
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_leds_increment,0)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_leds_increment)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_increment],NULL);
    if (result == NULL) {
       printf("[CRITICAL] leds_increment() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -7,8 +7,258 @@
 #include <stdio.h>
 #include "openwsnmodule.h"
 
+//=========================== RadioBuffer Class ===============================
+
+/**
+\brief A radio frame buffer of an OpenMote, for the Python buffer protocol.
+
+The memoryviews OpenMote.radio_tx_buffer() and OpenMote.radio_rx_buffer() return
+are over one of these, which keeps the mote alive as long as they are.
+*/
+typedef struct {
+   PyObject_HEAD
+   OpenMote*            mote;               // owns a reference
+   uint8_t*             buf;                // RADIO_FRAME_MAXLEN bytes, in the mote
+   int                  readonly;
+} RadioBuffer;
+
+static int RadioBuffer_getbuffer(RadioBuffer* self, Py_buffer* view, int flags) {
+   return PyBuffer_FillInfo(view,(PyObject*)self,self->buf,RADIO_FRAME_MAXLEN,self->readonly,flags);
+}
+
+static void RadioBuffer_dealloc(RadioBuffer* self) {
+   Py_XDECREF(self->mote);
+   PyObject_Del(self);
+}
+
+static PyBufferProcs RadioBuffer_as_buffer = {
+   0,                                  // bf_getreadbuffer
+   0,                                  // bf_getwritebuffer
+   0,                                  // bf_getsegcount
+   0,                                  // bf_getcharbuffer
+   (getbufferproc)RadioBuffer_getbuffer, // bf_getbuffer
+   0,                                  // bf_releasebuffer
+};
+
+static PyTypeObject openwsn_RadioBufferType = {
+   PyObject_HEAD_INIT(NULL)
+   0,                                  // ob_size
+   "openwsn_generic.RadioBuffer",      // tp_name
+   sizeof(RadioBuffer),                // tp_basicsize
+   0,                                  // tp_itemsize
+   (destructor)RadioBuffer_dealloc,    // tp_dealloc
+   0,                                  // tp_print
+   0,                                  // tp_getattr
+   0,                                  // tp_setattr
+   0,                                  // tp_compare
+   0,                                  // tp_repr
+   0,                                  // tp_as_number
+   0,                                  // tp_as_sequence
+   0,                                  // tp_as_mapping
+   0,                                  // tp_hash
+   0,                                  // tp_call
+   0,                                  // tp_str
+   0,                                  // tp_getattro
+   0,                                  // tp_setattro
+   &RadioBuffer_as_buffer,             // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, // tp_flags
+   "Radio frame buffer of an OpenMote", // tp_doc
+};
+
+/**
+\brief A memoryview over one of the radio frame buffers of a mote.
+*/
+static PyObject* radioBuffer_memoryview(OpenMote* mote, uint8_t* buf, int readonly) {
+   RadioBuffer* radioBuffer;
+   PyObject*    returnVal;
+   
+   radioBuffer = PyObject_New(RadioBuffer,&openwsn_RadioBufferType);
+   if (radioBuffer==NULL) {
+      return NULL;
+   }
+   Py_INCREF(mote);
+   radioBuffer->mote     = mote;
+   radioBuffer->buf      = buf;
+   radioBuffer->readonly = readonly;
+   
+   returnVal   = PyMemoryView_FromObject((PyObject*)radioBuffer);
+   Py_DECREF(radioBuffer);
+   return returnVal;
+}
+
 //=========================== OpenMote Class ==================================
 
+//===== notifications
+
+/**
+\brief Count a notification, and tell whether to forward it to Python.
+
+A notification is forwarded if Python subscribed to it, see
+OpenMote.set_subscriptions(), and set a callback for it. The BSP modules call
+this before building any argument, so the others cost no allocation. The GIL is
+taken back before forwarding, if the mote released it; every TRUE must be
+followed by mote_notifyDone(), error paths included.
+*/
+bool mote_isSubscribed(OpenMote* self, uint8_t notifId) {
+   self->notifCounts[notifId]++;
+   if (
+         ((self->notifUnsubscribed[notifId/32]>>(notifId%32))&0x01)!=0 ||
+         self->callback[notifId]==NULL
+      ) {
+      return FALSE;
+   }
+   mote_acquireGil(self);
+   return TRUE;
+}
+
+/**
+\brief Done forwarding a notification mote_isSubscribed() let through.
+
+Releases the GIL again, if the mote runs without it.
+*/
+void mote_notifyDone(OpenMote* self) {
+   mote_releaseGil(self);
+}
+
+/// Notifications which can be logged, see eventlog_t.
+static const uint8_t eventlog_loggable[] = {
+   MOTE_NOTIF_debugpins_frame_toggle,
+   MOTE_NOTIF_debugpins_frame_clr,
+   MOTE_NOTIF_debugpins_frame_set,
+   MOTE_NOTIF_debugpins_slot_toggle,
+   MOTE_NOTIF_debugpins_slot_clr,
+   MOTE_NOTIF_debugpins_slot_set,
+   MOTE_NOTIF_debugpins_fsm_toggle,
+   MOTE_NOTIF_debugpins_fsm_clr,
+   MOTE_NOTIF_debugpins_fsm_set,
+   MOTE_NOTIF_debugpins_task_toggle,
+   MOTE_NOTIF_debugpins_task_clr,
+   MOTE_NOTIF_debugpins_task_set,
+   MOTE_NOTIF_debugpins_isr_toggle,
+   MOTE_NOTIF_debugpins_isr_clr,
+   MOTE_NOTIF_debugpins_isr_set,
+   MOTE_NOTIF_debugpins_radio_toggle,
+   MOTE_NOTIF_debugpins_radio_clr,
+   MOTE_NOTIF_debugpins_radio_set,
+   MOTE_NOTIF_leds_error_on,
+   MOTE_NOTIF_leds_error_off,
+   MOTE_NOTIF_leds_error_toggle,
+   MOTE_NOTIF_leds_error_blink,
+   MOTE_NOTIF_leds_radio_on,
+   MOTE_NOTIF_leds_radio_off,
+   MOTE_NOTIF_leds_radio_toggle,
+   MOTE_NOTIF_leds_sync_on,
+   MOTE_NOTIF_leds_sync_off,
+   MOTE_NOTIF_leds_sync_toggle,
+   MOTE_NOTIF_leds_debug_on,
+   MOTE_NOTIF_leds_debug_off,
+   MOTE_NOTIF_leds_debug_toggle,
+   MOTE_NOTIF_leds_all_on,
+   MOTE_NOTIF_leds_all_off,
+   MOTE_NOTIF_leds_all_toggle,
+   MOTE_NOTIF_leds_circular_shift,
+   MOTE_NOTIF_leds_increment,
+   MOTE_NOTIF_uart_writeByte,
+};
+
+/**
+\brief Log a notification, if Python asked for it.
+
+A logged notification is counted, but never forwarded to Python. When the log
+is full, the record is dropped; drain_events() tells how many were.
+
+\param[in] notifId Which notification, one of MOTE_NOTIF_*.
+\param[in] arg     Its argument.
+
+\returns TRUE if the notification is logged, or dropped, FALSE otherwise.
+*/
+bool mote_logEvent(OpenMote* self, uint8_t notifId, uint8_t arg) {
+   uint8_t*  record;
+   uint32_t  time;
+   
+   if (((self->eventLog.logged[notifId/32]>>(notifId%32))&0x01)==0) {
+      return FALSE;
+   }
+   self->notifCounts[notifId]++;
+   
+   if (self->eventLog.idxW-self->eventLog.idxR>=EVENTLOG_NUM_RECORDS) {
+      self->eventLog.numDropped++;
+      return TRUE;
+   }
+   
+   time      = (uint32_t)(self->native.now>>NATIVE_SUBTICK_SHIFT);
+   record    = &self->eventLog.ring[(self->eventLog.idxW&(EVENTLOG_NUM_RECORDS-1))*EVENTLOG_RECORD_LEN];
+   record[0] = notifId;
+   record[1] = arg;
+   record[2] = (time>> 0)&0xff;
+   record[3] = (time>> 8)&0xff;
+   record[4] = (time>>16)&0xff;
+   record[5] = (time>>24)&0xff;
+   self->eventLog.idxW++;
+   self->eventLog.numRecords++;
+   return TRUE;
+}
+
+//===== GIL
+
+/**
+\brief Release the GIL while the mote runs C code, see OpenMote.
+
+Called when Python calls into the mote; mote_endAllowThreads() must follow,
+before returning to Python. Calls nest.
+*/
+void mote_allowThreads(OpenMote* self) {
+   self->numAllowThreads++;
+   mote_releaseGil(self);
+}
+
+void mote_endAllowThreads(OpenMote* self) {
+   mote_acquireGil(self);
+   self->numAllowThreads--;
+}
+
+/**
+\brief Take back the GIL, to call Python, if the mote released it.
+*/
+void mote_acquireGil(OpenMote* self) {
+   if (self->threadState!=NULL) {
+      PyEval_RestoreThread(self->threadState);
+      self->threadState = NULL;
+      self->isBusy      = FALSE;
+   }
+}
+
+/**
+\brief Release the GIL again, once the mote is back to running C code.
+
+Only between mote_allowThreads() and mote_endAllowThreads().
+*/
+void mote_releaseGil(OpenMote* self) {
+   if (self->numAllowThreads>0 && self->threadState==NULL) {
+      // while still holding the GIL, so no other thread sees the mote idle
+      self->isBusy      = TRUE;
+      self->threadState = PyEval_SaveThread();
+   }
+}
+
+/**
+\brief Refuse a call while the mote runs, without the GIL, on another thread.
+
+The mote only holds the GIL while calling Python, so a method called from
+Python while it released the GIL comes from another thread, see OpenMote.
+isBusy is set before the GIL is released, so no thread can see the mote idle
+in between.
+
+\returns TRUE, with a RuntimeError set, if the call must be refused.
+*/
+static bool mote_isBusy(OpenMote* self) {
+   if (self->isBusy==TRUE) {
+      PyErr_SetString(PyExc_RuntimeError, "the mote is running on another thread");
+      return TRUE;
+   }
+   return FALSE;
+}
+
 //===== members
 
 //===== methods
@@ -17,17 +267,28 @@ static PyObject* OpenMote_set_callback(OpenMote* self, PyObject* args) {
    int       cmdId;
    PyObject* tempCallback;
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // parse arguments
    if (!PyArg_ParseTuple(args, "iO:set_callback", &cmdId, &tempCallback)) {
       return NULL;
    }
    
    // make sure cmdId is plausible
-   if (cmdId<0 || cmdId>MOTE_NOTIF_LAST) {
+   if (cmdId<0 || cmdId>=MOTE_NOTIF_LAST) {
       PyErr_SetString(PyExc_TypeError, "wrong cmdId");
       return NULL;
    }
    
+   // None unsubscribes, the native BSP then handles the call alone
+   if (tempCallback==Py_None) {
+      Py_XDECREF(self->callback[cmdId]);
+      self->callback[cmdId] = NULL;
+      Py_RETURN_NONE;
+   }
+   
    // make sure tempCallback is callable
    if (!PyCallable_Check(tempCallback)) {
       PyErr_SetString(PyExc_TypeError, "parameter must be callable");
@@ -43,6 +304,349 @@ static PyObject* OpenMote_set_callback(OpenMote* self, PyObject* args) {
    Py_RETURN_NONE;
 }
 
+/**
+\brief Choose the notifications forwarded to Python.
+
+All are, by default. The others return right away, and are only counted.
+
+Arguments: a bitmask, as an integer; bit i set subscribes to notification i.
+*/
+static PyObject* OpenMote_set_subscriptions(OpenMote* self, PyObject* args) {
+   PyObject* mask;
+   PyObject* word;
+   PyObject* shift;
+   uint8_t   i;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "O:set_subscriptions", &mask)) {
+      return NULL;
+   }
+   if (!PyInt_Check(mask) && !PyLong_Check(mask)) {
+      PyErr_SetString(PyExc_TypeError, "mask must be an integer");
+      return NULL;
+   }
+   
+   // 32 bits at a time
+   for (i=0;i<MOTE_NOTIFMASK_LEN;i++) {
+      shift = PyInt_FromLong(32*i);
+      word  = PyNumber_Rshift(mask,shift);
+      Py_DECREF(shift);
+      if (word==NULL) {
+         return NULL;
+      }
+      self->notifUnsubscribed[i] = ~(uint32_t)PyInt_AsUnsignedLongMask(word);
+      Py_DECREF(word);
+   }
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+/**
+\brief The number of times each notification was raised, forwarded or not.
+
+\returns A list, indexed by notification.
+*/
+static PyObject* OpenMote_get_notif_counts(OpenMote* self) {
+   PyObject* returnVal;
+   PyObject* count;
+   uint8_t   i;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   returnVal = PyList_New(MOTE_NOTIF_LAST);
+   if (returnVal==NULL) {
+      return NULL;
+   }
+   for (i=0;i<MOTE_NOTIF_LAST;i++) {
+      count = PyLong_FromUnsignedLong(self->notifCounts[i]);
+      if (count==NULL) {
+         Py_DECREF(returnVal);
+         return NULL;
+      }
+      PyList_SET_ITEM(returnVal,i,count);
+   }
+   return returnVal;
+}
+
+/**
+\brief Choose the notifications logged rather than forwarded to Python.
+
+See eventlog_t. None are, by default.
+
+Arguments: a bitmask, as an integer; bit i set logs notification i. Only
+uart_writeByte, and the debugpins and leds notifications which return nothing,
+can be logged.
+*/
+static PyObject* OpenMote_set_event_log(OpenMote* self, PyObject* args) {
+   PyObject* mask;
+   PyObject* word;
+   PyObject* shift;
+   uint32_t  logged[MOTE_NOTIFMASK_LEN];
+   uint32_t  loggable[MOTE_NOTIFMASK_LEN];
+   uint8_t   i;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "O:set_event_log", &mask)) {
+      return NULL;
+   }
+   if (!PyInt_Check(mask) && !PyLong_Check(mask)) {
+      PyErr_SetString(PyExc_TypeError, "mask must be an integer");
+      return NULL;
+   }
+   
+   // 32 bits at a time
+   for (i=0;i<MOTE_NOTIFMASK_LEN;i++) {
+      shift = PyInt_FromLong(32*i);
+      word  = PyNumber_Rshift(mask,shift);
+      Py_DECREF(shift);
+      if (word==NULL) {
+         return NULL;
+      }
+      logged[i] = (uint32_t)PyInt_AsUnsignedLongMask(word);
+      Py_DECREF(word);
+   }
+   
+   // only the loggable notifications
+   memset(loggable,0,sizeof(loggable));
+   for (i=0;i<sizeof(eventlog_loggable);i++) {
+      loggable[eventlog_loggable[i]/32] |= 1ul<<(eventlog_loggable[i]%32);
+   }
+   for (i=0;i<MOTE_NOTIFMASK_LEN;i++) {
+      if ((logged[i]&~loggable[i])!=0) {
+         PyErr_SetString(PyExc_ValueError, "mask has notifications which cannot be logged");
+         return NULL;
+      }
+   }
+   memcpy(self->eventLog.logged,logged,sizeof(logged));
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+/**
+\brief Read, and remove, the records of the event log.
+
+If records were dropped, log full, the last record is an EVENTLOG_ID_DROPPED one
+whose argument says how many, at most 255, timestamped when drained.
+
+\returns The records, back to back, as a string; see eventlog_t.
+*/
+static PyObject* OpenMote_drain_events(OpenMote* self) {
+   PyObject* returnVal;
+   uint8_t*  buf;
+   uint32_t  numRecords;
+   uint32_t  idxR;
+   uint32_t  len;
+   uint32_t  time;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   numRecords = self->eventLog.idxW-self->eventLog.idxR;
+   len        = numRecords*EVENTLOG_RECORD_LEN;
+   if (self->eventLog.numDropped>0) {
+      len    += EVENTLOG_RECORD_LEN;
+   }
+   
+   returnVal  = PyString_FromStringAndSize(NULL,len);
+   if (returnVal==NULL) {
+      return NULL;
+   }
+   buf        = (uint8_t*)PyString_AS_STRING(returnVal);
+   
+   // at most two copies, the log wraps around once
+   idxR       = self->eventLog.idxR&(EVENTLOG_NUM_RECORDS-1);
+   if (idxR+numRecords>EVENTLOG_NUM_RECORDS) {
+      memcpy(buf,&self->eventLog.ring[idxR*EVENTLOG_RECORD_LEN],(EVENTLOG_NUM_RECORDS-idxR)*EVENTLOG_RECORD_LEN);
+      memcpy(
+         &buf[(EVENTLOG_NUM_RECORDS-idxR)*EVENTLOG_RECORD_LEN],
+         self->eventLog.ring,
+         (idxR+numRecords-EVENTLOG_NUM_RECORDS)*EVENTLOG_RECORD_LEN
+      );
+   } else {
+      memcpy(buf,&self->eventLog.ring[idxR*EVENTLOG_RECORD_LEN],numRecords*EVENTLOG_RECORD_LEN);
+   }
+   
+   if (self->eventLog.numDropped>0) {
+      time    = (uint32_t)(self->native.now>>NATIVE_SUBTICK_SHIFT);
+      buf    += numRecords*EVENTLOG_RECORD_LEN;
+      buf[0]  = EVENTLOG_ID_DROPPED;
+      buf[1]  = (self->eventLog.numDropped>0xff) ? 0xff : (uint8_t)self->eventLog.numDropped;
+      buf[2]  = (time>> 0)&0xff;
+      buf[3]  = (time>> 8)&0xff;
+      buf[4]  = (time>>16)&0xff;
+      buf[5]  = (time>>24)&0xff;
+   }
+   
+   self->eventLog.idxR        = self->eventLog.idxW;
+   self->eventLog.numDropped  = 0;
+   self->eventLog.numDrained++;
+   return returnVal;
+}
+
+/**
+\brief The frame the mote last loaded in its radio, read-only.
+
+\returns A memoryview over the RADIO_FRAME_MAXLEN bytes of the TX buffer;
+   radio_loadPacket tells how many the frame uses. Only filled in after
+   set_radio_buffers().
+*/
+static PyObject* OpenMote_radio_tx_buffer(OpenMote* self) {
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   return radioBuffer_memoryview(self,self->radio_frames.txBuf,TRUE);
+}
+
+/**
+\brief Where Python writes the frames the mote receives.
+
+\returns A writable memoryview over the RADIO_FRAME_MAXLEN bytes of the RX
+   buffer. Only read after set_radio_buffers().
+*/
+static PyObject* OpenMote_radio_rx_buffer(OpenMote* self) {
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   return radioBuffer_memoryview(self,self->radio_frames.rxBuf,FALSE);
+}
+
+/**
+\brief Exchange the radio frames through the buffers of the mote.
+
+Call before supply_on(). From then on, the radio_loadPacket callback gets the
+length of the frame, which it reads from radio_tx_buffer(), and the
+radio_getReceivedFrame callback writes the frame to radio_rx_buffer() and
+returns a (length, rssi, lqi, crc) tuple, instead of lists of ints.
+*/
+static PyObject* OpenMote_set_radio_buffers(OpenMote* self) {
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   self->radio_frames.enabled = TRUE;
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+/**
+\brief Emulate the board, bsp_timer, debugpins, leds and uart modules in C.
+
+Call before supply_on(). From then on, these modules only call Python for the
+notifications it set a callback for; the radio, radiotimer and eui64 modules
+still need theirs. Python reaches the UART with uart_rx_write() and
+uart_tx_read().
+
+Arguments: the baudrate of the UART, NATIVE_UART_BAUDRATE by default.
+*/
+static PyObject* OpenMote_set_native(OpenMote* self, PyObject* args) {
+   unsigned int baudrate;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   // parse arguments
+   baudrate = NATIVE_UART_BAUDRATE;
+   if (!PyArg_ParseTuple(args, "|I:set_native", &baudrate)) {
+      return NULL;
+   }
+   if (baudrate==0) {
+      PyErr_SetString(PyExc_ValueError, "baudrate must be positive");
+      return NULL;
+   }
+   
+   board_nativeInit(self,baudrate);
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+/**
+\brief The native clock, in bsp_timer ticks.
+*/
+static PyObject* OpenMote_get_time(OpenMote* self) {
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   return PyFloat_FromDouble((double)self->native.now/(1<<NATIVE_SUBTICK_SHIFT));
+}
+
+/**
+\brief Read, and remove, the bytes the mote wrote on the native UART.
+*/
+static PyObject* OpenMote_uart_tx_read(OpenMote* self) {
+   PyObject* returnVal;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   returnVal = PyString_FromStringAndSize((char*)self->native.uartTxBuf,self->native.uartTxLen);
+   self->native.uartTxLen = 0;
+   return returnVal;
+}
+
+/**
+\brief Send bytes to the mote over the native UART.
+
+The bytes arrive one after the other, after the ones still on the wire.
+
+Arguments: the bytes, as a string.
+
+\returns The native clock, in ticks, at which the last byte arrives.
+*/
+static PyObject* OpenMote_uart_rx_write(OpenMote* self, PyObject* args) {
+   const char* buf;
+   int         len;
+   int         i;
+   uint16_t    numQueued;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "s#:uart_rx_write", &buf, &len)) {
+      return NULL;
+   }
+   
+   numQueued = self->native.uartRxIdxW-self->native.uartRxIdxR;
+   if (numQueued==0) {
+      // the line is idle
+      self->native.uartRxNextTime = self->native.now+self->native.uartByteTime;
+   }
+   for (i=0;i<len;i++) {
+      if (numQueued==NATIVE_UART_RX_SIZE) {
+         self->native.uartNumRxDropped += len-i;
+         break;
+      }
+      self->native.uartRxBuf[self->native.uartRxIdxW&(NATIVE_UART_RX_SIZE-1)] = buf[i];
+      self->native.uartRxIdxW++;
+      numQueued++;
+   }
+   
+   return PyFloat_FromDouble(
+      (double)(self->native.uartRxNextTime+(uint64_t)(numQueued-1)*self->native.uartByteTime)/(1<<NATIVE_SUBTICK_SHIFT)
+   );
+}
+
 static PyObject* OpenMote_getState(OpenMote* self) {
    PyObject* returnVal;
    PyObject* uart_icb_tx;
@@ -72,6 +676,12 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    PyObject* openserial_vars;
    PyObject* scheduler_vars;
    PyObject* scheduler_dbg;
+   PyObject* native;
+   PyObject* eventLog;
+   
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
    
    returnVal = PyDict_New();
    
@@ -191,15 +801,44 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    // TODO
    PyDict_SetItemString(returnVal, "scheduler_dbg", scheduler_dbg);
    
+   // native BSP
+   native = PyDict_New();
+   PyDict_SetItemString(native, "enabled",          PyBool_FromLong(self->native.enabled));
+   PyDict_SetItemString(native, "time",             PyFloat_FromDouble((double)self->native.now/(1<<NATIVE_SUBTICK_SHIFT)));
+   PyDict_SetItemString(native, "numStuckSleeps",   PyInt_FromLong(self->native.numStuckSleeps));
+   PyDict_SetItemString(native, "leds",             PyInt_FromLong(self->native.leds));
+   PyDict_SetItemString(native, "debugpins",        PyInt_FromLong(self->native.debugpins));
+   PyDict_SetItemString(native, "timerCounter",     PyInt_FromLong(bsp_timer_nativeCounter(self)));
+   PyDict_SetItemString(native, "timerArmed",       PyBool_FromLong(self->native.timerArmed));
+   PyDict_SetItemString(native, "uartTxLen",        PyInt_FromLong(self->native.uartTxLen));
+   PyDict_SetItemString(native, "uartNumTxDropped", PyInt_FromLong(self->native.uartNumTxDropped));
+   PyDict_SetItemString(native, "uartRxLen",        PyInt_FromLong((uint16_t)(self->native.uartRxIdxW-self->native.uartRxIdxR)));
+   PyDict_SetItemString(native, "uartNumRxDropped", PyInt_FromLong(self->native.uartNumRxDropped));
+   PyDict_SetItemString(returnVal, "native", native);
+   
+   // event log
+   eventLog = PyDict_New();
+   PyDict_SetItemString(eventLog, "len",            PyInt_FromLong(self->eventLog.idxW-self->eventLog.idxR));
+   PyDict_SetItemString(eventLog, "numDropped",     PyInt_FromLong(self->eventLog.numDropped));
+   PyDict_SetItemString(eventLog, "numRecords",     PyLong_FromUnsignedLong(self->eventLog.numRecords));
+   PyDict_SetItemString(eventLog, "numDrained",     PyLong_FromUnsignedLong(self->eventLog.numDrained));
+   PyDict_SetItemString(returnVal, "eventLog", eventLog);
+   
    return returnVal;
 }
 
 static PyObject* OpenMote_bsp_timer_isr(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    bsp_timer_isr(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -208,6 +847,10 @@ static PyObject* OpenMote_bsp_timer_isr(OpenMote* self) {
 static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
    int capturedTime;
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // parse the arguments
    if (!PyArg_ParseTuple(args, "i", &capturedTime)) {
       return NULL;
@@ -218,11 +861,13 @@ static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
       return NULL;
    }
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    radio_intr_startOfFrame(
       self,
       (uint16_t)capturedTime
    );
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -231,6 +876,10 @@ static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
 static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
    int capturedTime;
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // parse the arguments
    if (!PyArg_ParseTuple(args, "i", &capturedTime)) {
       return NULL;
@@ -241,11 +890,13 @@ static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
       return NULL;
    }
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    radio_intr_endOfFrame(
       self,
       (uint16_t)capturedTime
    );
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -253,10 +904,16 @@ static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
 
 static PyObject* OpenMote_radiotimer_isr_compare(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    radiotimer_intr_compare(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -264,10 +921,16 @@ static PyObject* OpenMote_radiotimer_isr_compare(OpenMote* self) {
 
 static PyObject* OpenMote_radiotimer_isr_overflow(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    radiotimer_intr_overflow(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -275,10 +938,16 @@ static PyObject* OpenMote_radiotimer_isr_overflow(OpenMote* self) {
 
 static PyObject* OpenMote_uart_isr_tx(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    uart_intr_tx(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -286,10 +955,16 @@ static PyObject* OpenMote_uart_isr_tx(OpenMote* self) {
 
 static PyObject* OpenMote_uart_isr_rx(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    uart_intr_rx(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -297,10 +972,16 @@ static PyObject* OpenMote_uart_isr_rx(OpenMote* self) {
 
 static PyObject* OpenMote_supply_on(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
-   // call the callback
+   // call the callback, without the GIL
+   mote_allowThreads(self);
    supply_on(self);
+   mote_endAllowThreads(self);
    
    // return successfully
    Py_RETURN_NONE;
@@ -308,6 +989,10 @@ static PyObject* OpenMote_supply_on(OpenMote* self) {
 
 static PyObject* OpenMote_supply_off(OpenMote* self) {
    
+   if (mote_isBusy(self)) {
+      return NULL;
+   }
+   
    // no arguments
    
    // call the callback
@@ -327,14 +1012,25 @@ static PyMethodDef OpenMote_methods[] = {
    //=== admin
    {  "set_callback",             (PyCFunction)OpenMote_set_callback,               METH_VARARGS,  ""},
    {  "getState",                 (PyCFunction)OpenMote_getState,                   METH_NOARGS,   ""},
+   {  "set_subscriptions",        (PyCFunction)OpenMote_set_subscriptions,          METH_VARARGS,  ""},
+   {  "get_notif_counts",         (PyCFunction)OpenMote_get_notif_counts,           METH_NOARGS,   ""},
+   {  "set_event_log",            (PyCFunction)OpenMote_set_event_log,              METH_VARARGS,  ""},
+   {  "drain_events",             (PyCFunction)OpenMote_drain_events,               METH_NOARGS,   ""},
+   {  "set_native",               (PyCFunction)OpenMote_set_native,                 METH_VARARGS,  ""},
+   {  "get_time",                 (PyCFunction)OpenMote_get_time,                   METH_NOARGS,   ""},
    //=== BSP
    {  "bsp_timer_isr",            (PyCFunction)OpenMote_bsp_timer_isr,              METH_NOARGS,   ""},
    {  "radio_isr_startFrame",     (PyCFunction)OpenMote_radio_isr_startFrame,       METH_VARARGS,  ""},
    {  "radio_isr_endFrame",       (PyCFunction)OpenMote_radio_isr_endFrame,         METH_VARARGS,  ""},
+   {  "set_radio_buffers",        (PyCFunction)OpenMote_set_radio_buffers,          METH_NOARGS,   ""},
+   {  "radio_tx_buffer",          (PyCFunction)OpenMote_radio_tx_buffer,            METH_NOARGS,   ""},
+   {  "radio_rx_buffer",          (PyCFunction)OpenMote_radio_rx_buffer,            METH_NOARGS,   ""},
    {  "radiotimer_isr_compare",   (PyCFunction)OpenMote_radiotimer_isr_compare,     METH_NOARGS,   ""},
    {  "radiotimer_isr_overflow",  (PyCFunction)OpenMote_radiotimer_isr_overflow,    METH_NOARGS,   ""},
    {  "uart_isr_tx",              (PyCFunction)OpenMote_uart_isr_tx,                METH_NOARGS,   ""},
    {  "uart_isr_rx",              (PyCFunction)OpenMote_uart_isr_rx,                METH_NOARGS,   ""},
+   {  "uart_tx_read",             (PyCFunction)OpenMote_uart_tx_read,               METH_NOARGS,   ""},
+   {  "uart_rx_write",            (PyCFunction)OpenMote_uart_rx_write,              METH_VARARGS,  ""},
    {  "supply_on",                (PyCFunction)OpenMote_supply_on,                  METH_NOARGS,   ""},
    {  "supply_off",               (PyCFunction)OpenMote_supply_off,                 METH_NOARGS,   ""},
    {NULL} // sentinel
@@ -421,6 +1117,12 @@ PyMODINIT_FUNC initopenwsn_generic(void) {
    if (PyType_Ready(&openwsn_OpenMoteType) < 0) {
       return;
    }
+   if (PyType_Ready(&openwsn_RadioBufferType) < 0) {
+      return;
+   }
+   
+   // motes release the GIL, see OpenMote
+   PyEval_InitThreads();
    
    // initialize the openwsn module
    openwsn_module = Py_InitModule3(
@@ -13,6 +13,7 @@
 // OpenWSN
 #include "openserial_obj.h"
 #include "opentimers_obj.h"
+#include "opentrace_obj.h"
 #include "scheduler_obj.h"
 #include "IEEE802154E_obj.h"
 #include "neighbors_obj.h"
@@ -121,10 +122,15 @@ enum {
    MOTE_NOTIF_uart_clearTxInterrupts,
    MOTE_NOTIF_uart_writeByte,
    MOTE_NOTIF_uart_readByte,
+   // added later, after the others so their ids do not change
+   MOTE_NOTIF_board_sleepFor,
+   MOTE_NOTIF_uart_writeBuffer,
    // last
    MOTE_NOTIF_LAST
 };
 
+#define MOTE_NOTIFMASK_LEN        ((MOTE_NOTIF_LAST+31)/32)
+
 typedef void (*uart_tx_cbt)(OpenMote* self);
 typedef void (*uart_rx_cbt)(OpenMote* self);
 
@@ -146,6 +152,28 @@ typedef struct {
    radiotimer_capture_cbt    endFrame_cb;
 } radio_icb_t;
 
+/// Size of the radio frame buffers, in bytes, CRC included.
+#define RADIO_FRAME_MAXLEN        127
+
+/**
+\brief Radio frame buffers, once Python calls OpenMote.set_radio_buffers().
+
+By default, radio_loadPacket() passes the frame to Python as a list of ints,
+and the radio_getReceivedFrame callback returns one. After
+OpenMote.set_radio_buffers(), Python gets these buffers as memoryviews, with
+OpenMote.radio_tx_buffer() and OpenMote.radio_rx_buffer(), once, and reads or
+writes the frames through them: radio_loadPacket() copies the frame to txBuf
+and only tells Python its length; Python writes the received frame to rxBuf,
+and its radio_getReceivedFrame callback returns the length. Between two motes,
+a frame is copied by a slice assignment, without one Python object per byte.
+*/
+typedef struct {
+   bool                 enabled;            // set by OpenMote.set_radio_buffers()
+   uint8_t              txBuf[RADIO_FRAME_MAXLEN];
+   uint8_t              txLen;
+   uint8_t              rxBuf[RADIO_FRAME_MAXLEN];
+} radio_frames_t;
+
 typedef void (*radiotimer_compare_cbt)(OpenMote* self);
 
 typedef struct {
@@ -153,18 +181,146 @@ typedef struct {
    radiotimer_compare_cbt    compare_cb;
 } radiotimer_icb_t;
 
+//===== native BSP
+
+/// Fraction of a bsp_timer tick the native clock counts, as a shift.
+#define NATIVE_SUBTICK_SHIFT      8
+#define NATIVE_TICKS_PER_S        32768
+#define NATIVE_UART_BAUDRATE      115200     // default, see OpenMote.set_native()
+#define NATIVE_UART_TX_SIZE       4096       // bytes kept until Python reads them
+#define NATIVE_UART_RX_SIZE       1024       // bytes, a power of two
+
+#if (NATIVE_UART_RX_SIZE&(NATIVE_UART_RX_SIZE-1))!=0
+#error NATIVE_UART_RX_SIZE must be a power of two
+#endif
+
+// bits of native_bsp_t.leds
+#define NATIVE_LED_ERROR          0x01
+#define NATIVE_LED_RADIO          0x02
+#define NATIVE_LED_SYNC           0x04
+#define NATIVE_LED_DEBUG          0x08
+#define NATIVE_LED_ALL            0x0f
+
+// bits of native_bsp_t.debugpins
+#define NATIVE_DEBUGPIN_FRAME     0x01
+#define NATIVE_DEBUGPIN_SLOT      0x02
+#define NATIVE_DEBUGPIN_FSM       0x04
+#define NATIVE_DEBUGPIN_TASK      0x08
+#define NATIVE_DEBUGPIN_ISR       0x10
+#define NATIVE_DEBUGPIN_RADIO     0x20
+
+/**
+\brief State of the BSP emulated in C.
+
+Once Python calls OpenMote.set_native(), the board, bsp_timer, debugpins, leds
+and uart modules run on this state rather than calling Python. Python is only
+notified of the calls it subscribed to, see mote_isSubscribed(), and its return
+values are ignored; queries (leds_*_isOn, bsp_timer_get_currentValue, uart_readByte) are
+answered in C.
+
+The native clock is in 1/2^NATIVE_SUBTICK_SHIFT bsp_timer ticks. board_sleep()
+advances it to the next bsp_timer compare or UART interrupt, and handles it.
+*/
+typedef struct {
+   bool                 enabled;
+   uint64_t             now;                // native clock
+   uint32_t             numStuckSleeps;     // sleeps with nothing to wake up from
+   // leds, debugpins
+   uint8_t              leds;
+   uint8_t              debugpins;
+   // bsp_timer
+   uint64_t             timerResetTime;     // native clock at bsp_timer_reset()
+   PORT_TIMER_WIDTH     timerLastCompare;   // counter value of the last compare
+   bool                 timerArmed;
+   uint64_t             timerFireTime;      // native clock of the compare, if armed
+   // uart
+   uint32_t             uartByteTime;       // native clock a byte takes on the wire
+   bool                 uartTxBusy;
+   uint64_t             uartTxDoneTime;
+   uint8_t              uartTxBuf[NATIVE_UART_TX_SIZE];
+   uint16_t             uartTxLen;
+   uint32_t             uartNumTxDropped;   // bytes written while uartTxBuf was full
+   uint8_t              uartRxBuf[NATIVE_UART_RX_SIZE];
+   uint16_t             uartRxIdxW;         // free-running, as uartRxIdxR
+   uint16_t             uartRxIdxR;
+   uint64_t             uartRxNextTime;     // arrival of the byte at uartRxIdxR
+   uint8_t              uartRxByte;         // returned by uart_readByte()
+   uint32_t             uartNumRxDropped;   // bytes written while uartRxBuf was full
+} native_bsp_t;
+
+//=== event log
+
+/// Number of bytes of an event record: notification (1B), argument (1B), time (4B).
+#define EVENTLOG_RECORD_LEN       6
+
+/**
+\brief Number of event records the log holds.
+
+\warning Must be a power of two.
+*/
+#ifndef EVENTLOG_NUM_RECORDS
+#define EVENTLOG_NUM_RECORDS      4096
+#endif
+
+#if (EVENTLOG_NUM_RECORDS&(EVENTLOG_NUM_RECORDS-1))!=0
+#error EVENTLOG_NUM_RECORDS must be a power of two
+#endif
+
+/// Notification of the record saying how many were dropped, log full.
+#define EVENTLOG_ID_DROPPED       0xff
+
+/**
+\brief Notifications logged rather than forwarded to Python.
+
+Python picks the notifications to log with OpenMote.set_event_log(), among the
+high-volume ones which return nothing: uart_writeByte, debugpins and leds. They
+are then recorded in a ring, and Python reads the records of many with a single
+OpenMote.drain_events() call. A record is the notification, its argument (the
+byte of uart_writeByte, 0 otherwise) and the native clock in bsp_timer ticks,
+little-endian; with the Python BSP, which keeps the time in Python, it is 0.
+
+idxW and idxR run freely; their difference is the number of records in the log.
+*/
+typedef struct {
+   uint32_t             logged[MOTE_NOTIFMASK_LEN]; // bit set: logged
+   uint32_t             idxW;               // next record written
+   uint32_t             idxR;               // next record drained
+   uint32_t             numDropped;         // records dropped since the last drain
+   uint32_t             numRecords;         // records written, in total
+   uint32_t             numDrained;         // drain_events() calls
+   uint8_t              ring[EVENTLOG_NUM_RECORDS*EVENTLOG_RECORD_LEN];
+} eventlog_t;
+
 /**
 \brief Memory footprint of an OpenMote instance.
+
+Each mote has its own copy of the state of the stack, so motes run in parallel
+on separate threads: the methods which run the mote (supply_on() and the
+interrupts) release the GIL while in C code, and take it back to call Python,
+see mote_allowThreads(). A mote must be run by one thread at a time: its
+methods raise a RuntimeError when called while it runs on another thread.
 */
 struct OpenMote {
    PyObject_HEAD // No ';' allows since in macro
    //===== callbacks to Python
    PyObject*            callback[MOTE_NOTIF_LAST];
+   uint32_t             notifUnsubscribed[MOTE_NOTIFMASK_LEN]; // bit set: not forwarded
+   uint32_t             notifCounts[MOTE_NOTIF_LAST];           // forwarded or not
    //===== internal C callbacks
    uart_icb_t           uart_icb;
    bsp_timer_icb_t      bsp_timer_icb;
    radio_icb_t          radio_icb;
    radiotimer_icb_t     radiotimer_icb;
+   //===== radio frames
+   radio_frames_t       radio_frames;
+   //===== native BSP
+   native_bsp_t         native;
+   //===== event log
+   eventlog_t           eventLog;
+   //===== GIL
+   PyThreadState*       threadState;        // saved while the GIL is released
+   bool                 isBusy;             // set before releasing the GIL, see mote_isBusy()
+   uint8_t              numAllowThreads;    // nested calls from Python
    //===== state
    // l7
    ohlone_vars_t        ohlone_vars;
@@ -190,11 +346,32 @@ struct OpenMote {
    openqueue_vars_t     openqueue_vars;
    // drivers
    opentimers_vars_t    opentimers_vars;
+   opentimers_dbg_t     opentimers_dbg;
    random_vars_t        random_vars;
    openserial_vars_t    openserial_vars;
+   openserial_dbg_t     openserial_dbg;
+   opentrace_vars_t     opentrace_vars;
+   opentrace_dbg_t      opentrace_dbg;
    // kernel
    scheduler_vars_t     scheduler_vars;
    scheduler_dbg_t      scheduler_dbg;
 };
 
+//=========================== prototypes ======================================
+
+// notifications
+bool             mote_isSubscribed(OpenMote* self, uint8_t notifId);
+void             mote_notifyDone(OpenMote* self);
+bool             mote_logEvent(OpenMote* self, uint8_t notifId, uint8_t arg);
+// GIL
+void             mote_allowThreads(OpenMote* self);
+void             mote_endAllowThreads(OpenMote* self);
+void             mote_acquireGil(OpenMote* self);
+void             mote_releaseGil(OpenMote* self);
+// native BSP
+void             board_nativeInit(OpenMote* self, uint32_t baudrate);
+void             board_nativeSleep(OpenMote* self);
+PORT_TIMER_WIDTH bsp_timer_nativeCounter(OpenMote* self);
+void             uart_nativeWrite(OpenMote* self, uint8_t* buf, uint16_t len);
+
 #endif
\ No newline at end of file
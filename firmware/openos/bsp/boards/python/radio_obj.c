@@ -77,13 +77,19 @@ void radio_init(OpenMote* self) {
    printf("C@0x%x: radio_init()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -99,13 +105,19 @@ void radio_reset(OpenMote* self) {
    printf("C@0x%x: radio_reset()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_reset)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_reset],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_reset() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -122,15 +134,21 @@ void radio_startTimer(OpenMote* self, PORT_TIMER_WIDTH period) {
    printf("C@0x%x: radio_startTimer(period=%d)... \n",self,period);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_startTimer)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_startTimer],arglist);
    if (result == NULL) {
       printf("[CRITICAL] radio_startTimer() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -145,14 +163,20 @@ PORT_TIMER_WIDTH radio_getTimerValue(OpenMote* self) {
    printf("C@0x%x: radio_getTimerValue()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_getTimerValue)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getTimerValue],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_getTimerValue() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] radio_getTimerValue() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -164,6 +188,7 @@ PORT_TIMER_WIDTH radio_getTimerValue(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -175,15 +200,21 @@ void radio_setTimerPeriod(OpenMote* self, PORT_TIMER_WIDTH period) {
    printf("C@0x%x: radio_setTimerPeriod(period=%d)... \n",self,period);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_setTimerPeriod)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setTimerPeriod],arglist);
    if (result == NULL) {
       printf("[CRITICAL] radio_setTimerPeriod() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -198,14 +229,20 @@ PORT_TIMER_WIDTH radio_getTimerPeriod(OpenMote* self) {
    printf("C@0x%x: radio_getTimerPeriod()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_getTimerPeriod)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getTimerPeriod],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_getTimerPeriod() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] radio_getTimerPeriod() returned something which is not an int\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -217,6 +254,7 @@ PORT_TIMER_WIDTH radio_getTimerPeriod(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -230,15 +268,21 @@ void radio_setFrequency(OpenMote* self, uint8_t frequency) {
    printf("C@0x%x: radio_setFrequency(frequency=%d)... \n",self,frequency);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_setFrequency)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",frequency);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setFrequency],arglist);
    if (result == NULL) {
       printf("[CRITICAL] radio_setFrequency() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -252,13 +296,19 @@ void radio_rfOn(OpenMote* self) {
    printf("C@0x%x: radio_rfOn()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_rfOn)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOn],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_rfOn() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -272,13 +322,19 @@ void radio_rfOff(OpenMote* self) {
    printf("C@0x%x: radio_rfOff()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_rfOff)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOff],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_rfOff() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -287,37 +343,65 @@ void radio_rfOff(OpenMote* self) {
 
 //===== TX
 
+/**
+\brief Hand a frame to Python.
+
+By default, the callback gets the frame as a list of ints. After
+OpenMote.set_radio_buffers(), the frame is copied to the TX buffer, which
+Python reads through OpenMote.radio_tx_buffer(), and the callback only gets
+its length.
+*/
 void radio_loadPacket(OpenMote* self, uint8_t* packet, uint8_t len) {
    PyObject*   pkt;
    PyObject*   arglist;
    PyObject*   result;
    PyObject*   item;
-   int8_t      i;
-   int         res;
+   uint8_t     i;
    
 #ifdef TRACE_ON
    printf("C@0x%x: radio_loadPacket(len=%d)... \n",self,len);
 #endif
    
+   if (self->radio_frames.enabled==TRUE) {
+      if (len>RADIO_FRAME_MAXLEN) {
+         printf("[CRITICAL] radio_loadPacket() frame of %d bytes truncated\r\n",len);
+         len  = RADIO_FRAME_MAXLEN;
+      }
+      memcpy(self->radio_frames.txBuf,packet,len);
+      self->radio_frames.txLen = len;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_loadPacket)) {
+      return;
+   }
+   
    // forward to Python
-   pkt        = PyList_New(len);
-   for (i=0;i<len;i++) {
-      item    = PyInt_FromLong(packet[i]);
-      res     = PyList_SetItem(pkt,i,item);
-      if (res!=0) {
-         printf("[CRITICAL] radio_loadPacket() failed setting list item\r\n");
+   if (self->radio_frames.enabled==TRUE) {
+      // Python reads the frame from radio_tx_buffer()
+      arglist = Py_BuildValue("(i)",len);
+   } else {
+      pkt     = PyList_New(len);
+      if (pkt == NULL) {
+         printf("[CRITICAL] radio_loadPacket() failed creating list\r\n");
+         mote_notifyDone(self);
          return;
       }
+      for (i=0;i<len;i++) {
+         item = PyInt_FromLong(packet[i]);
+         // steals the reference to item
+         PyList_SET_ITEM(pkt,i,item);
+      }
+      arglist = Py_BuildValue("(N)",pkt);
    }
-   arglist    = Py_BuildValue("(O)",pkt);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_loadPacket],arglist);
+   Py_DECREF(arglist);
    if (result == NULL) {
       printf("[CRITICAL] radio_loadPacket() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
-   Py_DECREF(arglist);
-   Py_DECREF(pkt);
+   mote_notifyDone(self);
 }
 
 void radio_txEnable(OpenMote* self) {
@@ -327,13 +411,19 @@ void radio_txEnable(OpenMote* self) {
    printf("C@0x%x: radio_txEnable()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_txEnable)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txEnable],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_txEnable() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -347,13 +437,19 @@ void radio_txNow(OpenMote* self) {
    printf("C@0x%x: radio_txNow()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_txNow)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txNow],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_txNow() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -369,13 +465,19 @@ void radio_rxEnable(OpenMote* self) {
    printf("C@0x%x: radio_rxEnable()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_rxEnable)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxEnable],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_rxEnable() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -389,19 +491,33 @@ void radio_rxNow(OpenMote* self) {
    printf("C@0x%x: radio_rxNow()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_rxNow)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxNow],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_rxNow() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
 #endif
 }
 
+/**
+\brief Get the received frame from Python.
+
+The callback returns a (frame, rssi, lqi, crc) tuple, the frame a list of
+ints. After OpenMote.set_radio_buffers(), Python writes the frame to the RX
+buffer, through OpenMote.radio_rx_buffer(), and the first item of the tuple is
+its length instead.
+*/
 void radio_getReceivedFrame(OpenMote* self,
                              uint8_t* pBufRead,
                              uint8_t* pLenRead,
@@ -412,39 +528,60 @@ void radio_getReceivedFrame(OpenMote* self,
    PyObject*  result;
    PyObject*  item;
    PyObject*  subitem;
-   int8_t     lenRead;
-   int8_t     i;
+   long       lenRead;
+   long       i;
    
 #ifdef TRACE_ON
    printf("C@0x%x: radio_getReceivedFrame()... \n",self);
 #endif
    
+   *pLenRead  = 0;
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radio_getReceivedFrame)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getReceivedFrame],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radio_getReceivedFrame() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    
    // verify
-   if (!PySequence_Check(result)) {
-      printf("[CRITICAL] radio_getReceivedFrame() did not return a tuple\r\n");
-      return;
-   }
-   if (PyTuple_Size(result)!=4) {
-      printf("[CRITICAL] radio_getReceivedFrame() did not return a tuple of exactly 4 elements %d\r\n",PyList_Size(result));
+   if (!PyTuple_Check(result) || PyTuple_Size(result)!=4) {
+      printf("[CRITICAL] radio_getReceivedFrame() did not return a tuple of exactly 4 elements\r\n");
+      Py_DECREF(result);
+      mote_notifyDone(self);
       return;
    }
    
-   //==== item 0: rxBuffer
+   //==== item 0: the frame, or its length in rxBuf
    
    item       = PyTuple_GetItem(result,0);
-   lenRead    = PyList_Size(item);
-   *pLenRead  = lenRead;
-   // store retrieved information
-   for (i=0;i<lenRead;i++) {
-      subitem = PyList_GetItem(item, i);
-      pBufRead[i] = (uint8_t)PyInt_AsLong(subitem);
+   if (self->radio_frames.enabled==TRUE) {
+      lenRead = PyInt_AsLong(item);
+   } else if (PyList_Check(item)) {
+      lenRead = PyList_Size(item);
+   } else {
+      lenRead = -1;
+   }
+   if (lenRead<0 || lenRead>RADIO_FRAME_MAXLEN || lenRead>maxBufLen) {
+      printf("[CRITICAL] radio_getReceivedFrame() returned an invalid frame, length %ld\r\n",lenRead);
+      PyErr_Clear();
+      Py_DECREF(result);
+      mote_notifyDone(self);
+      return;
+   }
+   *pLenRead  = (uint8_t)lenRead;
+   if (self->radio_frames.enabled==TRUE) {
+      memcpy(pBufRead,self->radio_frames.rxBuf,lenRead);
+   } else {
+      for (i=0;i<lenRead;i++) {
+         subitem     = PyList_GetItem(item,i);
+         pBufRead[i] = (uint8_t)PyInt_AsLong(subitem);
+      }
    }
    
    //==== item 1: rssi
@@ -461,6 +598,9 @@ void radio_getReceivedFrame(OpenMote* self,
    
    item       = PyTuple_GetItem(result,3);
    *pCrc      = (uint8_t)PyInt_AsLong(item);
+   
+   Py_DECREF(result);
+   mote_notifyDone(self);
 }
 
 //=========================== interrupts ======================================
@@ -49,13 +49,19 @@ void radiotimer_init(OpenMote* self) {
    printf("C@0x%x: radiotimer_init()... \n",self,self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -69,13 +75,19 @@ void radiotimer_start(OpenMote* self, uint16_t period) {
    printf("C@0x%x: radiotimer_start(period=%d)... \n",self,period);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_start)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_start],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_start() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -92,14 +104,20 @@ uint16_t radiotimer_getValue(OpenMote* self) {
    printf("C@0x%x: radiotimer_getValue()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_getValue)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getValue],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_getValue() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] radiotimer_getValue() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -111,6 +129,7 @@ uint16_t radiotimer_getValue(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -122,15 +141,21 @@ void radiotimer_setPeriod(OpenMote* self, uint16_t period) {
    printf("C@0x%x: radiotimer_setPeriod(period=%d)... \n",self,period);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_setPeriod)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_setPeriod],arglist);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_setPeriod() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -145,14 +170,20 @@ uint16_t radiotimer_getPeriod(OpenMote* self) {
    printf("C@0x%x: radiotimer_getPeriod()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_getPeriod)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getPeriod],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_getPeriod() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] radiotimer_getPeriod() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -164,6 +195,7 @@ uint16_t radiotimer_getPeriod(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
@@ -177,15 +209,21 @@ void radiotimer_schedule(OpenMote* self, uint16_t offset) {
    printf("C@0x%x: radiotimer_schedule(offset=%d)... \n",self,offset);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_schedule)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",offset);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_schedule],arglist);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_schedule() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -199,13 +237,19 @@ void radiotimer_cancel(OpenMote* self) {
    printf("C@0x%x: radiotimer_cancel()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_cancel)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_cancel],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_cancel() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -222,14 +266,20 @@ uint16_t radiotimer_getCapturedTime(OpenMote* self) {
    printf("C@0x%x: radiotimer_getCapturedTime()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_radiotimer_getCapturedTime)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getCapturedTime],NULL);
    if (result == NULL) {
       printf("[CRITICAL] radiotimer_getCapturedTime() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] radiotimer_getCapturedTime() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -241,6 +291,7 @@ uint16_t radiotimer_getCapturedTime(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
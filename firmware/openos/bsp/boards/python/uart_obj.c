@@ -37,13 +37,23 @@ void uart_init(OpenMote* self) {
    printf("C@0x%x: uart_init()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      self->native.uartTxBusy       = FALSE;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_init)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_init],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_init() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -57,13 +67,19 @@ void uart_enableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_enableInterrupts()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_enableInterrupts)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_enableInterrupts],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_enableInterrupts() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -77,13 +93,19 @@ void uart_disableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_disableInterrupts()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_disableInterrupts)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_disableInterrupts],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_disableInterrupts() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -97,13 +119,19 @@ void uart_clearRxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearRxInterrupts()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_clearRxInterrupts)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearRxInterrupts],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_clearRxInterrupts() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -117,13 +145,19 @@ void uart_clearTxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearTxInterrupts()... \n",self);
 #endif
    
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_clearTxInterrupts)) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearTxInterrupts],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_clearTxInterrupts() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -138,15 +172,89 @@ void uart_writeByte(OpenMote* self, uint8_t byteToWrite) {
    printf("C@0x%x: uart_writeByte()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      uart_nativeWrite(self,&byteToWrite,1);
+   }
+   
+   if (mote_logEvent(self,MOTE_NOTIF_uart_writeByte,byteToWrite)) {
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_writeByte)) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",byteToWrite);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_writeByte],arglist);
    if (result == NULL) {
       printf("[CRITICAL] uart_writeByte() returned NULL\r\n");
+      mote_notifyDone(self);
       return;
    }
    Py_DECREF(result);
    Py_DECREF(arglist);
+   mote_notifyDone(self);
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: ...done.\n",self);
+#endif
+}
+
+/**
+\brief Hand a buffer to Python, as a list of bytes.
+
+Python calls the TX interrupt once it sent the whole buffer. A simulator which
+does not implement uart_writeBuffer gets the bytes one by one. With the native
+BSP, the C UART sends the buffer, and Python only gets a copy if it set a
+callback.
+*/
+void uart_writeBuffer(OpenMote* self, uint8_t* buf, uint16_t len) {
+   PyObject*   pkt;
+   PyObject*   arglist;
+   PyObject*   result;
+   PyObject*   item;
+   uint16_t    i;
+   
+#ifdef TRACE_ON
+   printf("C@0x%x: uart_writeBuffer(len=%d)... \n",self,len);
+#endif
+   
+   if (self->native.enabled) {
+      uart_nativeWrite(self,buf,len);
+   } else if (self->callback[MOTE_NOTIF_uart_writeBuffer]==NULL) {
+      for (i=0;i<len;i++) {
+         uart_writeByte(self,buf[i]);
+      }
+      return;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_writeBuffer)) {
+      return;
+   }
+   
+   // forward to Python
+   pkt        = PyList_New(len);
+   if (pkt == NULL) {
+      printf("[CRITICAL] uart_writeBuffer() failed creating list\r\n");
+      mote_notifyDone(self);
+      return;
+   }
+   for (i=0;i<len;i++) {
+      item    = PyInt_FromLong(buf[i]);
+      // steals the reference to item
+      PyList_SET_ITEM(pkt,i,item);
+   }
+   arglist    = Py_BuildValue("(N)",pkt);
+   result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_writeBuffer],arglist);
+   Py_XDECREF(arglist);
+   if (result == NULL) {
+      printf("[CRITICAL] uart_writeBuffer() returned NULL\r\n");
+      mote_notifyDone(self);
+      return;
+   }
+   Py_DECREF(result);
+   mote_notifyDone(self);
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -161,14 +269,24 @@ uint8_t uart_readByte(OpenMote* self) {
    printf("C@0x%x: uart_readByte()... \n",self);
 #endif
    
+   if (self->native.enabled) {
+      return self->native.uartRxByte;
+   }
+   
+   if (!mote_isSubscribed(self,MOTE_NOTIF_uart_readByte)) {
+      return 0;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_readByte],NULL);
    if (result == NULL) {
       printf("[CRITICAL] uart_readByte() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    if (!PyInt_Check(result)) {
       printf("[CRITICAL] uart_readByte() returned NULL\r\n");
+      mote_notifyDone(self);
       return 0;
    }
    returnVal = PyInt_AsLong(result);
@@ -180,9 +298,31 @@ uint8_t uart_readByte(OpenMote* self) {
    printf("C@0x%x: ...got %d.\n",self,returnVal);
 #endif
    
+   mote_notifyDone(self);
    return returnVal;
 }
 
+/**
+\brief Write bytes on the native UART, see OpenMote.set_native().
+
+The TX interrupt fires once the last byte is on the wire. The bytes wait in
+uartTxBuf until Python reads them with OpenMote.uart_tx_read().
+*/
+void uart_nativeWrite(OpenMote* self, uint8_t* buf, uint16_t len) {
+   uint16_t numCopied;
+   
+   numCopied = NATIVE_UART_TX_SIZE-self->native.uartTxLen;
+   if (numCopied>len) {
+      numCopied = len;
+   }
+   memcpy(&self->native.uartTxBuf[self->native.uartTxLen],buf,numCopied);
+   self->native.uartTxLen        += numCopied;
+   self->native.uartNumTxDropped += len-numCopied;
+   
+   self->native.uartTxBusy        = TRUE;
+   self->native.uartTxDoneTime    = self->native.now+(uint64_t)len*self->native.uartByteTime;
+}
+
 //=========================== interrupt handlers ==============================
 
 void uart_intr_tx(OpenMote* self) {
@@ -12,6 +12,15 @@
  
 //=========================== define ==========================================
 
+/**
+\brief Boards which can send a whole buffer in the background, e.g. with DMA,
+define UART_HAS_WRITEBUFFER in their board_info.h and implement
+uart_writeBuffer().
+
+uart_writeBuffer() returns right away, the buffer must then be left untouched
+until the TX callback is called, once, when all its bytes are sent.
+*/
+
 //=========================== typedef =========================================
 
 typedef enum {
@@ -33,6 +42,9 @@ void    uart_disableInterrupts();
 void    uart_clearRxInterrupts();
 void    uart_clearTxInterrupts();
 void    uart_writeByte(uint8_t byteToWrite);
+#ifdef UART_HAS_WRITEBUFFER
+void    uart_writeBuffer(uint8_t* buf, uint16_t len);
+#endif
 uint8_t uart_readByte();
 
 // interrupt handlers
@@ -25,6 +25,39 @@
 #define HDLC_CRCINIT         0xffff
 #define HDLC_CRCGOOD         0xf0b8
 
+/**
+\brief Number of bytes crc16_update() processes per iteration: 1, 4 or 8.
+
+Processing N bytes at once takes N-1 tables of 512 bytes on top of fcstab, so
+the byte-wise version is kept for the small 16-bit and 8-bit micro-controllers.
+*/
+#ifndef HDLC_CRC_SLICE
+#if defined(__MSP430__) || defined(__ICC430__) || defined(__AVR__)
+#define HDLC_CRC_SLICE       1
+#else
+#define HDLC_CRC_SLICE       8
+#endif
+#endif
+
+#if HDLC_CRC_SLICE!=1 && HDLC_CRC_SLICE!=4 && HDLC_CRC_SLICE!=8
+#error HDLC_CRC_SLICE must be 1, 4 or 8
+#endif
+
+/**
+\brief Whether openhdlc_runLength() tests 4 bytes at a time for HDLC_FLAG and
+HDLC_ESCAPE, which only pays off on 32-bit micro-controllers and hosts.
+*/
+#ifndef HDLC_SCAN_WORDS
+#if defined(__MSP430__) || defined(__ICC430__) || defined(__AVR__)
+#define HDLC_SCAN_WORDS      0
+#else
+#define HDLC_SCAN_WORDS      1
+#endif
+#endif
+
+/// returned by openhdlc_escape() and openhdlc_encode() when dst is too small
+#define HDLC_NO_ROOM         0xffff
+
 //this table is used to expedite execution (at the expense of memory usage)
 static const uint16_t fcstab[256] = {
    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
@@ -63,9 +96,46 @@ static const uint16_t fcstab[256] = {
 
 //=========================== typedef =========================================
 
+/// Outcome of openhdlc_decode().
+typedef enum {
+   HDLC_DECODE_BUSY         = 0,            ///< no frame completed yet
+   HDLC_DECODE_FRAME        = 1,            ///< valid frame, CRC removed
+   HDLC_DECODE_BADCRC       = 2,            ///< frame dropped, wrong CRC
+   HDLC_DECODE_OVERFLOW     = 3,            ///< frame dropped, longer than buf
+} openhdlc_decode_t;
+
+/**
+\brief State of an incremental HDLC decoder, see openhdlc_decode().
+
+After openhdlc_decode() returns HDLC_DECODE_FRAME, the first len bytes of buf
+hold the frame, until the next call.
+*/
+typedef struct {
+   uint8_t*             buf;                // where frames are decoded
+   uint16_t             size;               // number of bytes in buf
+   uint16_t             len;                // number of bytes decoded
+   bool                 inFrame;            // has an opening flag been seen?
+   bool                 escaping;           // was the last byte HDLC_ESCAPE?
+   bool                 overflow;           // did the frame exceed buf?
+   bool                 complete;           // was a frame returned?
+} openhdlc_decoder_t;
+
 //=========================== prototypes ======================================
 
 uint16_t crcIteration(uint16_t crc, uint8_t byte);
+uint16_t crc16_update(uint16_t crc, const uint8_t* buf, uint16_t len);
+// encoder
+uint16_t openhdlc_runLength(const uint8_t* buf, uint16_t len);
+uint16_t openhdlc_escape(uint8_t* dst, uint16_t dstSize,
+                         const uint8_t* src, uint16_t srcLen);
+uint16_t openhdlc_encode(uint8_t* dst, uint16_t dstSize,
+                         const uint8_t* src, uint16_t srcLen);
+// decoder
+void     openhdlc_decoderInit(openhdlc_decoder_t* dec,
+                              uint8_t* buf, uint16_t size);
+uint16_t openhdlc_decode(openhdlc_decoder_t* dec,
+                         const uint8_t* src, uint16_t srcLen,
+                         openhdlc_decode_t* outcome);
 
 /**
 \}
@@ -20,10 +20,13 @@
 #include "uart.h"
 #include "opentimers.h"
 #include "openhdlc.h"
+#include "opentrace.h"
+#include "scheduler.h"
 
 //=========================== variables =======================================
 
 openserial_vars_t openserial_vars;
+openserial_dbg_t  openserial_dbg;
 
 //=========================== prototypes ======================================
 
@@ -34,14 +37,45 @@ owerror_t openserial_printInfoErrorCritical(
    errorparameter_t arg1,
    errorparameter_t arg2
 );
+// kernel
+void      openserial_schedulerOverflow(task_cbt cb, task_prio_t prio, owerror_t outcome);
+// status
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+uint16_t* outputStatusSlot(uint8_t statusElement, uint8_t* buffer, uint8_t length);
+#endif
 // HDLC output
-void outputHdlcOpen();
-void outputHdlcWrite(uint8_t b);
-void outputHdlcClose();
-// HDLC input
-void inputHdlcOpen();
-void inputHdlcWrite(uint8_t b);
-void inputHdlcClose();
+bool      outputHdlcOpen(openserial_outputQueue_t* q);
+void      outputHdlcWrite(openserial_outputQueue_t* q, uint8_t b);
+void      outputHdlcWriteBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len);
+void      outputHdlcEscape(openserial_outputQueue_t* q, uint8_t b);
+owerror_t outputHdlcClose(openserial_outputQueue_t* q);
+void      outputHdlcPut(openserial_outputQueue_t* q, uint8_t b);
+void      outputHdlcPutBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len);
+#if SERIAL_COBS
+// COBS output
+void      outputCobsBlock(openserial_outputQueue_t* q);
+void      outputCobsCode(openserial_outputQueue_t* q);
+void      outputCobsPut(openserial_outputQueue_t* q, uint8_t b);
+void      outputCobsPutBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len);
+void      outputCobsEnd(openserial_outputQueue_t* q);
+#endif
+// uart output
+void      outputQueueInit(uint8_t queueId, volatile uint8_t* buf, uint16_t size, uint16_t budget);
+bool      outputWriteNext();
+void      outputWriteDone();
+owerror_t openserial_printRequest();
+owerror_t openserial_printFraming();
+void      task_openserialDispatch();
+// command FIFO (input)
+uint16_t  inputFifoHeadFill();
+uint8_t*  inputFifoHead();
+bool      inputFifoFull();
+void      inputFifoPop();
+void      inputDecoderNext();
+void      inputDispatch();
+void      inputSetFraming(uint8_t* buf, uint16_t len);
+// uart
+void      openserial_startUart();
 
 //=========================== public ==========================================
 
@@ -50,10 +84,17 @@ void openserial_init() {
    
    // reset variable
    memset(&openserial_vars,0,sizeof(openserial_vars_t));
+   memset(&openserial_dbg,0,sizeof(openserial_dbg_t));
    
    // admin
    openserial_vars.mode                = MODE_OFF;
    openserial_vars.debugPrintCounter   = 0;
+#if SERIAL_FULL_DUPLEX
+   openserial_vars.uartStarted         = FALSE;
+#endif
+#if SERIAL_COBS
+   openserial_vars.framing             = SERIAL_FRAMING_HDLC;
+#endif
    
    // input
    openserial_vars.reqFrame[0]         = HDLC_FLAG;
@@ -65,39 +106,91 @@ void openserial_init() {
    openserial_vars.reqFrame[3]         = (crc>>8)&0xff;
    openserial_vars.reqFrame[4]         = HDLC_FLAG;
    openserial_vars.reqFrameIdx         = 0;
-   openserial_vars.lastRxByte          = HDLC_FLAG;
-   openserial_vars.busyReceiving       = FALSE;
-   openserial_vars.inputEscaping       = FALSE;
-   openserial_vars.inputBufFill        = 0;
+   openhdlc_decoderInit(&openserial_vars.inputDecoder,NULL,0);
+   openserial_vars.inputFifoW          = 0;
+   openserial_vars.inputFifoR          = 0;
+   openserial_vars.inputBufBorrowed    = FALSE;
    
    // ouput
-   openserial_vars.outputBufFilled     = FALSE;
-   openserial_vars.outputBufIdxR       = 0;
-   openserial_vars.outputBufIdxW       = 0;
+   outputQueueInit(OUTPUT_QUEUE_CONTROL,
+                   openserial_vars.outputBufControl,
+                   SERIAL_OUTPUT_CONTROL_BUFFER_SIZE,
+                   0);
+   outputQueueInit(OUTPUT_QUEUE_ERROR,
+                   openserial_vars.outputBufError,
+                   SERIAL_OUTPUT_ERROR_BUFFER_SIZE,
+                   SERIAL_OUTPUT_ERROR_BUDGET);
+   outputQueueInit(OUTPUT_QUEUE_DATA,
+                   openserial_vars.outputBufData,
+                   SERIAL_OUTPUT_BUFFER_SIZE,
+                   SERIAL_OUTPUT_DATA_BUDGET);
+   outputQueueInit(OUTPUT_QUEUE_STATUS,
+                   openserial_vars.outputBufStatus,
+                   SERIAL_OUTPUT_STATUS_BUFFER_SIZE,
+                   SERIAL_OUTPUT_STATUS_BUDGET);
+   openserial_vars.outputTxQueue       = OUTPUT_QUEUE_MAX;
+   
+#ifdef OPENTRACE_ENABLED
+   // the trace channel goes over openserial
+   opentrace_init();
+#endif
+   
+   // so do the task list overflows, which the kernel can not print
+   scheduler_setOverflowCb(openserial_schedulerOverflow);
    
    // set callbacks
    uart_setCallbacks(isr_openserial_tx,
                      isr_openserial_rx);
 }
 
+/**
+\brief Print a status element, unless it did not change since last printed.
+
+\returns E_SUCCESS if the status element was printed, or did not need to be,
+   E_FAIL if it was dropped.
+*/
 owerror_t openserial_printStatus(uint8_t statusElement,uint8_t* buffer, uint8_t length) {
-   uint8_t i;
-   INTERRUPT_DECLARATION();
+   openserial_outputQueue_t* q;
+   owerror_t                 outcome;
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+   uint16_t*                 slot;
+   uint16_t                  crc;
    
-   DISABLE_INTERRUPTS();
-   openserial_vars.outputBufFilled  = TRUE;
-   outputHdlcOpen();
-   outputHdlcWrite(SERFRAME_MOTE2PC_STATUS);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-   outputHdlcWrite(statusElement);
-   for (i=0;i<length;i++){
-      outputHdlcWrite(buffer[i]);
-   }
-   outputHdlcClose();
-   ENABLE_INTERRUPTS();
+   crc  = 0;
+   slot = outputStatusSlot(statusElement,buffer,length);
+   if (slot!=NULL) {
+      crc = crcIteration(HDLC_CRCINIT,statusElement);
+      crc = crc16_update(crc,buffer,length);
+      if (crc==0) {
+         // 0 stands for "not printed"
+         crc = 1;
+      }
+      if (*slot==crc) {
+         openserial_vars.statusUnchanged = TRUE;
+         openserial_dbg.numStatusUnchanged++;
+         return E_SUCCESS;
+      }
+   }
+#endif
+   
+   q = &openserial_vars.outputQueue[OUTPUT_QUEUE_STATUS];
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
+   }
+   outputHdlcWrite(q,SERFRAME_MOTE2PC_STATUS);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+   outputHdlcWrite(q,statusElement);
+   outputHdlcWriteBuffer(q,buffer,length);
+   outcome = outputHdlcClose(q);
    
-   return E_SUCCESS;
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+   // only remember what the PC will receive
+   if (outcome==E_SUCCESS && slot!=NULL) {
+      *slot = crc;
+   }
+#endif
+   return outcome;
 }
 
 owerror_t openserial_printInfoErrorCritical(
@@ -107,53 +200,73 @@ owerror_t openserial_printInfoErrorCritical(
       errorparameter_t arg1,
       errorparameter_t arg2
    ) {
-   INTERRUPT_DECLARATION();
+   openserial_outputQueue_t* q;
    
-   DISABLE_INTERRUPTS();
-   openserial_vars.outputBufFilled  = TRUE;
-   outputHdlcOpen();
-   outputHdlcWrite(severity);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-   outputHdlcWrite(calling_component);
-   outputHdlcWrite(error_code);
-   outputHdlcWrite((uint8_t)((arg1 & 0xff00)>>8));
-   outputHdlcWrite((uint8_t) (arg1 & 0x00ff));
-   outputHdlcWrite((uint8_t)((arg2 & 0xff00)>>8));
-   outputHdlcWrite((uint8_t) (arg2 & 0x00ff));
-   outputHdlcClose();
-   ENABLE_INTERRUPTS();
+   // info frames are debug traffic, they wait behind data
+   if (severity==SERFRAME_MOTE2PC_INFO) {
+      q = &openserial_vars.outputQueue[OUTPUT_QUEUE_STATUS];
+   } else {
+      q = &openserial_vars.outputQueue[OUTPUT_QUEUE_ERROR];
+   }
    
-   return E_SUCCESS;
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
+   }
+   outputHdlcWrite(q,severity);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+   outputHdlcWrite(q,calling_component);
+   outputHdlcWrite(q,error_code);
+   outputHdlcWrite(q,(uint8_t)((arg1 & 0xff00)>>8));
+   outputHdlcWrite(q,(uint8_t) (arg1 & 0x00ff));
+   outputHdlcWrite(q,(uint8_t)((arg2 & 0xff00)>>8));
+   outputHdlcWrite(q,(uint8_t) (arg2 & 0x00ff));
+   return outputHdlcClose(q);
 }
 
 owerror_t openserial_printData(uint8_t* buffer, uint8_t length) {
-   uint8_t  i;
+   openserial_outputQueue_t* q;
    uint8_t  asn[5];
-   INTERRUPT_DECLARATION();
    
    // retrieve ASN
    ieee154e_getAsn(asn);// byte01,byte23,byte4
    
-   DISABLE_INTERRUPTS();
-   openserial_vars.outputBufFilled  = TRUE;
-   outputHdlcOpen();
-   outputHdlcWrite(SERFRAME_MOTE2PC_DATA);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[1]);
-   outputHdlcWrite(idmanager_getMyID(ADDR_16B)->addr_16b[0]);
-   outputHdlcWrite(asn[0]);
-   outputHdlcWrite(asn[1]);
-   outputHdlcWrite(asn[2]);
-   outputHdlcWrite(asn[3]);
-   outputHdlcWrite(asn[4]);
-   for (i=0;i<length;i++){
-      outputHdlcWrite(buffer[i]);
-   }
-   outputHdlcClose();
-   ENABLE_INTERRUPTS();
+   q = &openserial_vars.outputQueue[OUTPUT_QUEUE_DATA];
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
+   }
+   outputHdlcWrite(q,SERFRAME_MOTE2PC_DATA);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+   outputHdlcWrite(q,asn[0]);
+   outputHdlcWrite(q,asn[1]);
+   outputHdlcWrite(q,asn[2]);
+   outputHdlcWrite(q,asn[3]);
+   outputHdlcWrite(q,asn[4]);
+   outputHdlcWriteBuffer(q,buffer,length);
+   return outputHdlcClose(q);
+}
+
+#ifdef OPENTRACE_ENABLED
+/**
+\brief Print trace records, see opentrace_flush().
+
+Trace frames carry no ASN; the records are timestamped with the radiotimer.
+*/
+owerror_t openserial_printTrace(uint8_t* buffer, uint8_t length) {
+   openserial_outputQueue_t* q;
    
-   return E_SUCCESS;
+   q = &openserial_vars.outputQueue[OUTPUT_QUEUE_DATA];
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
+   }
+   outputHdlcWrite(q,SERFRAME_MOTE2PC_TRACE);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+   outputHdlcWriteBuffer(q,buffer,length);
+   return outputHdlcClose(q);
 }
+#endif
 
 owerror_t openserial_printInfo(uint8_t calling_component, uint8_t error_code,
                               errorparameter_t arg1,
@@ -202,24 +315,51 @@ owerror_t openserial_printCritical(uint8_t calling_component, uint8_t error_code
    );
 }
 
+/**
+\brief Number of data bytes of the frame received from the PC, at most 255.
+
+Frames with more data bytes are reported as 255 long, so reading them with
+openserial_getInputBuffer() fails; use openserial_getNumDataBytes16() and
+openserial_getInputBuffer16() to read them.
+*/
 uint8_t openserial_getNumDataBytes() {
-   uint8_t inputBufFill;
+   uint16_t numDataBytes;
+   
+   numDataBytes = openserial_getNumDataBytes16();
+   return (numDataBytes>0xff) ? 0xff : (uint8_t)numDataBytes;
+}
+
+/**
+\brief Copy the data bytes of the frame received from the PC.
+
+\returns The number of bytes copied, 0 if the frame holds more than
+   maxNumBytes data bytes.
+*/
+uint8_t openserial_getInputBuffer(uint8_t* bufferToWrite, uint8_t maxNumBytes) {
+   // never more than maxNumBytes
+   return (uint8_t)openserial_getInputBuffer16(bufferToWrite,maxNumBytes);
+}
+
+/// Same as openserial_getNumDataBytes(), for frames of up to 65534 data bytes.
+uint16_t openserial_getNumDataBytes16() {
+   uint16_t inputBufFill;
    INTERRUPT_DECLARATION();
    
    DISABLE_INTERRUPTS();
-   inputBufFill = openserial_vars.inputBufFill;
+   inputBufFill = inputFifoHeadFill();
    ENABLE_INTERRUPTS();
-
+   
    return inputBufFill-1; // removing the command byte
 }
 
-uint8_t openserial_getInputBuffer(uint8_t* bufferToWrite, uint8_t maxNumBytes) {
-   uint8_t numBytesWritten;
-   uint8_t inputBufFill;
+/// Same as openserial_getInputBuffer(), for frames of up to 65534 data bytes.
+uint16_t openserial_getInputBuffer16(uint8_t* bufferToWrite, uint16_t maxNumBytes) {
+   uint16_t numBytesWritten;
+   uint16_t inputBufFill;
    INTERRUPT_DECLARATION();
    
    DISABLE_INTERRUPTS();
-   inputBufFill = openserial_vars.inputBufFill;
+   inputBufFill = inputFifoHeadFill();
    ENABLE_INTERRUPTS();
    
    if (maxNumBytes<inputBufFill-1) {
@@ -229,176 +369,298 @@ uint8_t openserial_getInputBuffer(uint8_t* bufferToWrite, uint8_t maxNumBytes) {
       numBytesWritten = 0;
    } else {
       numBytesWritten = inputBufFill-1;
-      memcpy(bufferToWrite,&(openserial_vars.inputBuf[1]),numBytesWritten);
+      memcpy(bufferToWrite,&(inputFifoHead()[1]),numBytesWritten);
    }
    
    return numBytesWritten;
 }
 
+/**
+\brief Borrow the frame received from the PC, without copying it.
+
+Call this from the command handler the frame is dispatched to. The frame stays
+at the head of the command FIFO until openserial_releaseInputBuffer() is
+called, possibly from a later task; the frames behind it wait.
+
+\param[out] len The number of bytes of the frame, command byte excluded.
+
+\returns A pointer to the frame, past its command byte, or NULL if there is no
+   frame.
+*/
+uint8_t* openserial_borrowInputBuffer(uint16_t* len) {
+   uint8_t* buf;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   if (inputFifoHeadFill()==0) {
+      buf  = NULL;
+      *len = 0;
+   } else {
+      openserial_vars.inputBufBorrowed = TRUE;
+      buf  = &(inputFifoHead()[1]);
+      *len = inputFifoHeadFill()-1; // removing the command byte
+   }
+   ENABLE_INTERRUPTS();
+   
+   return buf;
+}
+
+/**
+\brief Give back the frame borrowed with openserial_borrowInputBuffer().
+*/
+void openserial_releaseInputBuffer() {
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   if (openserial_vars.inputBufBorrowed==TRUE) {
+      openserial_vars.inputBufBorrowed = FALSE;
+      inputFifoPop();
+   }
+   ENABLE_INTERRUPTS();
+   
+#if SERIAL_FULL_DUPLEX
+   // dispatch the frames which waited behind it
+   scheduler_push_task_coalesce(task_openserialDispatch,TASKPRIO_BUTTON);
+#endif
+}
+
 void openserial_startInput() {
    INTERRUPT_DECLARATION();
    
-   if (openserial_vars.inputBufFill>0) {
-      openserial_printError(COMPONENT_OPENSERIAL,ERR_INPUTBUFFER_LENGTH,
-                            (errorparameter_t)openserial_vars.inputBufFill,
-                            (errorparameter_t)0);
-      DISABLE_INTERRUPTS();
-      openserial_vars.inputBufFill=0;
-      ENABLE_INTERRUPTS();
+   if (inputFifoFull()==TRUE) {
+      // no room for a command, do not ask the PC for one
+      openserial_dbg.numInputFifoFull++;
+      return;
    }
    
-   uart_clearTxInterrupts();
-   uart_clearRxInterrupts();      // clear possible pending interrupts
-   uart_enableInterrupts();       // Enable USCI_A1 TX & RX interrupt
+   openserial_startUart();
    
+#if SERIAL_FULL_DUPLEX
+   // the PC may send commands at any time, this is for PCs which wait to be asked
+   openserial_printRequest();
+   DISABLE_INTERRUPTS();
+   openserial_vars.mode           = MODE_OUTPUT;
+   if (openserial_vars.outputBufLenTx==0) {
+      outputWriteNext();
+   }
+   ENABLE_INTERRUPTS();
+#else
    DISABLE_INTERRUPTS();
-   openserial_vars.busyReceiving  = FALSE;
+   if (openserial_vars.outputBufLenTx>0) {
+      // the UART is still sending the previous output, no room for a request
+      ENABLE_INTERRUPTS();
+      return;
+   }
    openserial_vars.mode           = MODE_INPUT;
    openserial_vars.reqFrameIdx    = 0;
    uart_writeByte(openserial_vars.reqFrame[openserial_vars.reqFrameIdx]);
    ENABLE_INTERRUPTS();
+#endif
 }
 
 void openserial_startOutput() {
    //schedule a task to get new status in the output buffer
    uint8_t debugPrintCounter;
+   uint8_t i;
+   uint8_t numTries;
    
    INTERRUPT_DECLARATION();
-   DISABLE_INTERRUPTS();
-   openserial_vars.debugPrintCounter = (openserial_vars.debugPrintCounter+1)%STATUS_MAX;
-   debugPrintCounter = openserial_vars.debugPrintCounter;
-   ENABLE_INTERRUPTS();
    
-   // print debug information
-   switch (debugPrintCounter) {
-      case STATUS_ISSYNC:
-         if (debugPrint_isSync()==TRUE) {
-            break;
-         }
-      case STATUS_ID:
-         if (debugPrint_id()==TRUE) {
-            break;
-         }
-      case STATUS_DAGRANK:
-         if (debugPrint_myDAGrank()==TRUE) {
-            break;
-         }
-      case STATUS_OUTBUFFERINDEXES:
-         if (debugPrint_outBufferIndexes()==TRUE) {
-            break;
-         }
-      case STATUS_ASN:
-         if (debugPrint_asn()==TRUE) {
-            break;
-         }
-      case STATUS_MACSTATS:
-         if (debugPrint_macStats()==TRUE) {
-            break;
-         }
-      case STATUS_SCHEDULE:
-         if(debugPrint_schedule()==TRUE) {
-            break;
-         }
-      case STATUS_BACKOFF:
-         if(debugPrint_backoff()==TRUE) {
-            break;
-         }
-      case STATUS_QUEUE:
-         if(debugPrint_queue()==TRUE) {
-            break;
-         }
-      case STATUS_NEIGHBORS:
-         if (debugPrint_neighbors()==TRUE) {
-            break;
-         }
-      default:
-         DISABLE_INTERRUPTS();
-         openserial_vars.debugPrintCounter=0;
-         ENABLE_INTERRUPTS();
+   // start a new output window; a frame being written counts in the new one
+   for (i=0;i<OUTPUT_QUEUE_MAX;i++) {
+      openserial_vars.outputQueue[i].numBytesWindow = 0;
    }
    
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+   // keyframe: forget what was printed, so all status elements are printed again
+   openserial_vars.statusWindowCounter++;
+   if (openserial_vars.statusWindowCounter>=SERIAL_STATUS_KEYFRAME_PERIOD) {
+      openserial_vars.statusWindowCounter = 0;
+      memset(openserial_vars.statusCrc,   0,sizeof(openserial_vars.statusCrc));
+      memset(openserial_vars.statusRowCrc,0,sizeof(openserial_vars.statusRowCrc));
+   }
+#endif
+   
+#ifdef OPENTRACE_ENABLED
+   // trace records first, they are what timing problems are debugged with
+   opentrace_flush();
+#endif
+   
+   // print debug information, skipping the status elements which did not change
+   numTries = 0;
+   do {
+      openserial_vars.statusUnchanged = FALSE;
+      numTries++;
+      
+      DISABLE_INTERRUPTS();
+      openserial_vars.debugPrintCounter = (openserial_vars.debugPrintCounter+1)%STATUS_LAST;
+      debugPrintCounter = openserial_vars.debugPrintCounter;
+      ENABLE_INTERRUPTS();
+      
+      switch (debugPrintCounter) {
+         case STATUS_ISSYNC:
+            if (debugPrint_isSync()==TRUE) {
+               break;
+            }
+         case STATUS_ID:
+            if (debugPrint_id()==TRUE) {
+               break;
+            }
+         case STATUS_DAGRANK:
+            if (debugPrint_myDAGrank()==TRUE) {
+               break;
+            }
+         case STATUS_OUTBUFFERINDEXES:
+            if (debugPrint_outBufferIndexes()==TRUE) {
+               break;
+            }
+         case STATUS_ASN:
+            if (debugPrint_asn()==TRUE) {
+               break;
+            }
+         case STATUS_MACSTATS:
+            if (debugPrint_macStats()==TRUE) {
+               break;
+            }
+         case STATUS_SCHEDULE:
+            if(debugPrint_schedule()==TRUE) {
+               break;
+            }
+         case STATUS_BACKOFF:
+            if(debugPrint_backoff()==TRUE) {
+               break;
+            }
+         case STATUS_QUEUE:
+            if(debugPrint_queue()==TRUE) {
+               break;
+            }
+         case STATUS_NEIGHBORS:
+            if (debugPrint_neighbors()==TRUE) {
+               break;
+            }
+         case STATUS_SCHEDULER:
+            if (debugPrint_scheduler()==TRUE) {
+               break;
+            }
+         case STATUS_SCHEDULERPROFILE:
+#ifdef SCHEDULER_PROFILING
+            if (debugPrint_schedulerProfile()==TRUE) {
+               break;
+            }
+#endif
+         case STATUS_OPENTIMERS:
+            if (debugPrint_opentimers()==TRUE) {
+               break;
+            }
+         case STATUS_OPENSERIAL:
+            if (debugPrint_openserial()==TRUE) {
+               break;
+            }
+#ifdef OPENTRACE_ENABLED
+         case STATUS_OPENTRACE:
+            if (debugPrint_opentrace()==TRUE) {
+               break;
+            }
+#endif
+         default:
+            DISABLE_INTERRUPTS();
+            openserial_vars.debugPrintCounter=0;
+            ENABLE_INTERRUPTS();
+      }
+   } while (openserial_vars.statusUnchanged==TRUE && numTries<STATUS_LAST);
+   
    // flush buffer
-   uart_clearTxInterrupts();
-   uart_clearRxInterrupts();          // clear possible pending interrupts
-   uart_enableInterrupts();           // Enable USCI_A1 TX & RX interrupt
+   openserial_startUart();
    DISABLE_INTERRUPTS();
    openserial_vars.mode=MODE_OUTPUT;
-   if (openserial_vars.outputBufFilled) {
-      uart_writeByte(openserial_vars.outputBuf[openserial_vars.outputBufIdxR++]);
-   } else {
+   if (openserial_vars.outputBufLenTx==0 && outputWriteNext()==FALSE) {
+#if SERIAL_FULL_DUPLEX==0
       openserial_stop();
+#endif
    }
    ENABLE_INTERRUPTS();
 }
 
 void openserial_stop() {
-   uint8_t inputBufFill;
-   uint8_t cmdByte;
-   bool busyReceiving;
+#if SERIAL_FULL_DUPLEX
+   // the UART keeps sending and receiving, commands are dispatched by a task
+#else
    INTERRUPT_DECLARATION();
    
    DISABLE_INTERRUPTS();
-   busyReceiving = openserial_vars.busyReceiving;
-   inputBufFill = openserial_vars.inputBufFill;
-   ENABLE_INTERRUPTS();
-   
+   openserial_vars.mode=MODE_OFF;
+#ifdef UART_HAS_WRITEBUFFER
+   if (openserial_vars.outputBufLenTx==0) {
+      // disable USCI_A1 TX & RX interrupt
+      uart_disableInterrupts();
+   }
+   // else the UART still reads the bytes it was handed; its TX interrupt
+   // releases them, and disables the interrupts, see isr_openserial_tx()
+#else
    // disable USCI_A1 TX & RX interrupt
    uart_disableInterrupts();
-   
-   DISABLE_INTERRUPTS();
-   openserial_vars.mode=MODE_OFF;
-   ENABLE_INTERRUPTS();
-   //the inputBuffer has to be reset if it is not reset where the data is read.
-   //or the function openserial_getInputBuffer is called (which resets the buffer)
-   if (busyReceiving==TRUE){
-      openserial_printError(COMPONENT_OPENSERIAL,ERR_BUSY_RECEIVING,
-                                  (errorparameter_t)0,
-                                  (errorparameter_t)inputBufFill);
+   // the byte handed to the UART is gone, whether or not it said so
+   outputWriteDone();
+#endif
+   if (openserial_vars.inputDecoder.inFrame==TRUE && openserial_vars.inputDecoder.complete==FALSE) {
+      openserial_dbg.numInputAborted++;
    }
+   // the next input window starts with a new frame
+   openhdlc_decoderInit(&openserial_vars.inputDecoder,NULL,0);
+   ENABLE_INTERRUPTS();
    
-   if (busyReceiving == FALSE && inputBufFill>0) {
-      DISABLE_INTERRUPTS();
-      cmdByte = openserial_vars.inputBuf[0];
-      ENABLE_INTERRUPTS();
-      switch (cmdByte) {
-         case SERFRAME_PC2MOTE_SETROOT:
-            idmanager_triggerAboutRoot();
-            break;
-         case SERFRAME_PC2MOTE_SETBRIDGE:
-            idmanager_triggerAboutBridge();
-            break;
-         case SERFRAME_PC2MOTE_DATA:
-            openbridge_triggerData();
-            break;
-         case SERFRAME_PC2MOTE_TRIGGERTCPINJECT:
-            tcpinject_trigger();
-            break;
-         case SERFRAME_PC2MOTE_TRIGGERUDPINJECT:
-            udpinject_trigger();
-            break;
-         case SERFRAME_PC2MOTE_TRIGGERICMPv6ECHO:
-            icmpv6echo_trigger();
-            break;
-         case SERFRAME_PC2MOTE_TRIGGERSERIALECHO:
-            //echo function must reset input buffer after reading the data.
-            openserial_echo(&openserial_vars.inputBuf[1],inputBufFill-1);
-            break;   
-         default:
-            openserial_printError(COMPONENT_OPENSERIAL,ERR_UNSUPPORTED_COMMAND,
-                                  (errorparameter_t)cmdByte,
-                                  (errorparameter_t)0);
-            //reset here as it is not being reset in any other callback
-            DISABLE_INTERRUPTS();
-            openserial_vars.inputBufFill = 0;
-            ENABLE_INTERRUPTS();
-            break;
-      }
+   inputDispatch();
+#endif
+}
+
+/**
+\brief Send a request frame to the PC, the cue for PCs which only send commands
+   when asked.
+
+\returns E_SUCCESS if the request frame was written, E_FAIL otherwise.
+*/
+owerror_t openserial_printRequest() {
+   openserial_outputQueue_t* q;
+   
+   q = &openserial_vars.outputQueue[OUTPUT_QUEUE_CONTROL];
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
    }
+   outputHdlcWrite(q,SERFRAME_MOTE2PC_REQUEST);
+   return outputHdlcClose(q);
+}
+
+/**
+\brief Tell the PC the framing of the frames printed from now on, see
+   SERIAL_COBS.
+
+This frame is the first one in that framing.
+
+\returns E_SUCCESS if the frame was written, E_FAIL otherwise.
+*/
+owerror_t openserial_printFraming() {
+   openserial_outputQueue_t* q;
    
-   DISABLE_INTERRUPTS();
-   openserial_vars.inputBufFill  = 0;
-   openserial_vars.busyReceiving = FALSE;
-   ENABLE_INTERRUPTS();
+   q = &openserial_vars.outputQueue[OUTPUT_QUEUE_CONTROL];
+   if (outputHdlcOpen(q)==FALSE) {
+      return E_FAIL;
+   }
+   outputHdlcWrite(q,SERFRAME_MOTE2PC_FRAMING);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[0]);
+   outputHdlcWrite(q,idmanager_getMyID(ADDR_16B)->addr_16b[1]);
+#if SERIAL_COBS
+   outputHdlcWrite(q,openserial_vars.framing);
+#else
+   outputHdlcWrite(q,SERIAL_FRAMING_HDLC);
+#endif
+   return outputHdlcClose(q);
+}
+
+/**
+\brief Dispatch the commands received from the PC, in full-duplex mode.
+*/
+void task_openserialDispatch() {
+   inputDispatch();
 }
 
 /**
@@ -413,114 +675,633 @@ bool debugPrint_outBufferIndexes() {
    uint16_t temp_buffer[2];
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   temp_buffer[0] = openserial_vars.outputBufIdxW;
-   temp_buffer[1] = openserial_vars.outputBufIdxR;
+   temp_buffer[0] = openserial_vars.outputQueue[OUTPUT_QUEUE_DATA].idxW;
+   temp_buffer[1] = openserial_vars.outputQueue[OUTPUT_QUEUE_DATA].idxR;
    ENABLE_INTERRUPTS();
    openserial_printStatus(STATUS_OUTBUFFERINDEXES,(uint8_t*)temp_buffer,sizeof(temp_buffer));
    return TRUE;
 }
 
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_openserial() {
+   openserial_dbg_t output;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   memcpy(&output,&openserial_dbg,sizeof(openserial_dbg_t));
+   ENABLE_INTERRUPTS();
+   
+   openserial_printStatus(STATUS_OPENSERIAL,(uint8_t*)&output,sizeof(openserial_dbg_t));
+   return TRUE;
+}
+
+/**
+\brief Print the scheduler statistics, over serial.
+
+The kernel does not depend on openserial, so openserial prints them.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_scheduler() {
+   scheduler_dbg_t output;
+   
+   scheduler_getDbg(&output);
+   openserial_printStatus(STATUS_SCHEDULER,(uint8_t*)&output,sizeof(scheduler_dbg_t));
+   return TRUE;
+}
+
+#ifdef SCHEDULER_PROFILING
+/**
+\brief Print the execution time statistics of one callback, over serial.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_schedulerProfile() {
+   scheduler_profile_dbg_t output;
+   
+   if (scheduler_getProfile(&output)==FALSE) {
+      return FALSE;
+   }
+   openserial_printStatus(STATUS_SCHEDULERPROFILE,(uint8_t*)&output,sizeof(scheduler_profile_dbg_t));
+   return TRUE;
+}
+#endif
+
 //=========================== private =========================================
 
+//===== kernel
+
+/**
+\brief Report a task list overflow, see scheduler_setOverflowCb().
+
+Prints the scheduler statistics right away, rather than at their turn in the
+status rotation; they hold how SCHEDULER_OVERFLOW_POLICY resolved the overflow.
+*/
+void openserial_schedulerOverflow(task_cbt cb, task_prio_t prio, owerror_t outcome) {
+   debugPrint_scheduler();
+}
+
+//===== status
+
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+/**
+\brief Where to remember the CRC of a status element printed.
+
+\returns A pointer to the CRC of the status element (or of its row) last
+   printed, NULL if changes to it are not tracked.
+*/
+uint16_t* outputStatusSlot(uint8_t statusElement, uint8_t* buffer, uint8_t length) {
+   uint8_t table;
+   
+   if (statusElement>=STATUS_LAST) {
+      return NULL;
+   }
+   
+   // tables, printed one row at a time
+   if (statusElement==STATUS_SCHEDULE || statusElement==STATUS_NEIGHBORS) {
+      table = (statusElement==STATUS_SCHEDULE) ? 0 : 1;
+      if (length==0 || buffer[0]>=SERIAL_STATUS_NUM_ROWS) {
+         return NULL;
+      }
+      return &openserial_vars.statusRowCrc[table][buffer[0]];
+   }
+   
+   return &openserial_vars.statusCrc[statusElement];
+}
+#endif
+
 //===== hdlc (output)
 
 /**
-\brief Start an HDLC frame in the output buffer.
+\brief Start an HDLC frame in an output queue.
+
+With SERIAL_COBS, the outputHdlc*() functions write a COBS frame instead if
+that is the framing asked for, see outputCobsBlock().
+
+\returns TRUE if the frame can be written, FALSE if another frame is being
+   written to that queue, which this call interrupted.
 */
-inline void outputHdlcOpen() {
+inline bool outputHdlcOpen(openserial_outputQueue_t* q) {
+   if (q->busy==TRUE) {
+      // the frame being written owns the end of the output buffer
+      openserial_dbg.numDroppedBusy[q-openserial_vars.outputQueue]++;
+      return FALSE;
+   }
+   q->busy                                            = TRUE;
+   
+   // the frame is written past idxW, which the consumer does not read
+   q->frameIdxW                                       = q->idxW;
+   q->frameOverflow                                   = FALSE;
+   
    // initialize the value of the CRC
-   openserial_vars.outputCrc                          = HDLC_CRCINIT;
+   q->crc                                             = HDLC_CRCINIT;
+   
+#if SERIAL_COBS
+   q->framing                                         = openserial_vars.framing;
+   if (q->framing==SERIAL_FRAMING_COBS) {
+      outputHdlcPut(q,COBS_DELIMITER);
+      outputCobsBlock(q);
+      return TRUE;
+   }
+#endif
    
    // write the opening HDLC flag
-   openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]     = HDLC_FLAG;
+   outputHdlcPut(q,HDLC_FLAG);
+   
+   return TRUE;
 }
 /**
 \brief Add a byte to the outgoing HDLC frame being built.
-
-\todo escape 0x7e and 0x7d.
 */
-inline void outputHdlcWrite(uint8_t b) {
+inline void outputHdlcWrite(openserial_outputQueue_t* q, uint8_t b) {
    
    // iterate through CRC calculator
-   openserial_vars.outputCrc = crcIteration(openserial_vars.outputCrc,b);
+   q->crc = crcIteration(q->crc,b);
    
    // add byte to buffer
+   outputHdlcEscape(q,b);
+}
+/**
+\brief Add a buffer to the outgoing HDLC frame being built.
+*/
+inline void outputHdlcWriteBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len) {
+   uint8_t run;
+   
+   // iterate through CRC calculator, several bytes at a time
+   q->crc = crc16_update(q->crc,buf,len);
+   
+#if SERIAL_COBS
+   if (q->framing==SERIAL_FRAMING_COBS) {
+      outputCobsPutBuffer(q,buf,len);
+      return;
+   }
+#endif
+   
+   // add bytes to buffer, a run of bytes which need no escaping at a time
+   while (len>0) {
+      run  = (uint8_t)openhdlc_runLength(buf,len);
+      outputHdlcPutBuffer(q,buf,run);
+      buf += run;
+      len -= run;
+      if (len>0) {
+         outputHdlcEscape(q,*buf);
+         buf++;
+         len--;
+      }
+   }
+}
+/**
+\brief Write a byte of the outgoing HDLC frame, escaped if needed.
+*/
+inline void outputHdlcEscape(openserial_outputQueue_t* q, uint8_t b) {
+#if SERIAL_COBS
+   if (q->framing==SERIAL_FRAMING_COBS) {
+      outputCobsPut(q,b);
+      return;
+   }
+#endif
    if (b==HDLC_FLAG || b==HDLC_ESCAPE) {
-      openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]  = HDLC_ESCAPE;
+      outputHdlcPut(q,HDLC_ESCAPE);
       b                                               = b^HDLC_ESCAPE_MASK;
    }
-   openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]     = b;
-   
+   outputHdlcPut(q,b);
 }
 /**
-\brief Finalize the outgoing HDLC frame.
+\brief Finalize the outgoing HDLC frame, and hand it over to the consumer.
+
+\returns E_SUCCESS if the frame was written whole, E_FAIL if it was dropped
+   since the output buffer is full, or the queue is over its budget.
 */
-inline void outputHdlcClose() {
+inline owerror_t outputHdlcClose(openserial_outputQueue_t* q) {
    uint16_t   finalCrc;
-    
+   uint16_t   frameLen;
+   uint8_t    queueId;
+   owerror_t  outcome;
+   INTERRUPT_DECLARATION();
+   
+   queueId    = q-openserial_vars.outputQueue;
+   
    // finalize the calculation of the CRC
-   finalCrc   = ~openserial_vars.outputCrc;
+   finalCrc   = ~q->crc;
    
    // write the CRC value
-   outputHdlcWrite((finalCrc>>0)&0xff);
-   outputHdlcWrite((finalCrc>>8)&0xff);
+   outputHdlcWrite(q,(finalCrc>>0)&0xff);
+   outputHdlcWrite(q,(finalCrc>>8)&0xff);
    
+#if SERIAL_COBS
+   if (q->framing==SERIAL_FRAMING_COBS) {
+      outputCobsEnd(q);
+   } else {
+      // write the closing HDLC flag
+      outputHdlcPut(q,HDLC_FLAG);
+   }
+#else
    // write the closing HDLC flag
-   openserial_vars.outputBuf[openserial_vars.outputBufIdxW++]   = HDLC_FLAG;
+   outputHdlcPut(q,HDLC_FLAG);
+#endif
+   
+   frameLen   = (q->frameIdxW-q->idxW)&q->mask;
+   if (q->frameOverflow==TRUE) {
+      openserial_dbg.numDroppedFull[queueId]++;
+      outcome = E_FAIL;
+   } else if (
+         q->budget>0                           &&
+         q->numBytesWindow>0                   &&
+         q->numBytesWindow+frameLen>q->budget
+      ) {
+      openserial_dbg.numDroppedBudget[queueId]++;
+      outcome = E_FAIL;
+   } else {
+      // publish the frame, once all its bytes are written
+      q->idxW                                         = q->frameIdxW;
+      q->numBytesWindow                              += frameLen;
+      openserial_dbg.numOutputFrames[queueId]++;
+      outcome = E_SUCCESS;
+   }
+   
+   q->busy                                            = FALSE;
+   
+   if (outcome==E_SUCCESS) {
+      // send it right away if the UART is running, but idle
+      DISABLE_INTERRUPTS();
+      if (openserial_vars.mode==MODE_OUTPUT && openserial_vars.outputBufLenTx==0) {
+         outputWriteNext();
+      }
+      ENABLE_INTERRUPTS();
+   }
+   
+   return outcome;
 }
+/**
+\brief Write a byte at the end of the outgoing HDLC frame, if it fits.
+*/
+inline void outputHdlcPut(openserial_outputQueue_t* q, uint8_t b) {
+   outputBufIdx_t next;
+   
+   if (q->frameOverflow==TRUE) {
+      return;
+   }
+   
+   next = (q->frameIdxW+1)&q->mask;
+   if (next==q->idxR) {
+      // output buffer full, the frame will be dropped
+      q->frameOverflow                                = TRUE;
+      return;
+   }
+   q->buf[q->frameIdxW]                               = b;
+   q->frameIdxW                                       = next;
+}
+/**
+\brief Write bytes at the end of the outgoing HDLC frame, if they all fit.
+*/
+inline void outputHdlcPutBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len) {
+   outputBufIdx_t idx;
+   outputBufIdx_t room;
+   
+   if (q->frameOverflow==TRUE) {
+      return;
+   }
+   
+   idx  = q->frameIdxW;
+   room = (q->idxR-idx-1)&q->mask;
+   if (len>room) {
+      // output buffer full, the frame will be dropped
+      q->frameOverflow                                = TRUE;
+      return;
+   }
+   while (len>0) {
+      q->buf[idx]                                     = *buf++;
+      idx                                             = (idx+1)&q->mask;
+      len--;
+   }
+   q->frameIdxW                                       = idx;
+}
+
+#if SERIAL_COBS
+
+//===== cobs (output)
 
-//===== hdlc (input)
+/**
+\brief Start a COBS block in the outgoing frame.
 
+COBS splits the frame into blocks, each a code byte then at most 254 non-zero
+bytes. A code of n<COBS_MAX_CODE means n-1 bytes, then a null byte which is not
+written; COBS_MAX_CODE means 254 bytes, and no null byte. The code is only
+known once the block is over: this leaves room for it, see outputCobsEnd().
+*/
+inline void outputCobsBlock(openserial_outputQueue_t* q) {
+   q->cobsCodeIdx                                     = q->frameIdxW;
+   q->cobsCode                                        = 1;
+   outputHdlcPut(q,0);
+}
+/**
+\brief Write the code of the current COBS block, in the room left for it.
+*/
+inline void outputCobsCode(openserial_outputQueue_t* q) {
+   if (q->frameOverflow==FALSE) {
+      q->buf[q->cobsCodeIdx]                          = q->cobsCode;
+   }
+}
 /**
-\brief Start an HDLC frame in the input buffer.
+\brief Write a byte of the outgoing COBS frame.
 */
-inline void inputHdlcOpen() {
-   // reset the input buffer index
-   openserial_vars.inputBufFill                       = 0;
+inline void outputCobsPut(openserial_outputQueue_t* q, uint8_t b) {
+   if (b==COBS_DELIMITER) {
+      outputCobsCode(q);
+      outputCobsBlock(q);
+      return;
+   }
+   outputHdlcPut(q,b);
+   q->cobsCode++;
+   if (q->cobsCode==COBS_MAX_CODE) {
+      outputCobsCode(q);
+      outputCobsBlock(q);
+   }
+}
+/**
+\brief Write a buffer to the outgoing COBS frame, a run of non-zero bytes at a
+   time.
+*/
+inline void outputCobsPutBuffer(openserial_outputQueue_t* q, uint8_t* buf, uint8_t len) {
+   uint8_t run;
+   uint8_t maxRun;
    
-   // initialize the value of the CRC
-   openserial_vars.inputCrc                           = HDLC_CRCINIT;
+   while (len>0) {
+      maxRun = COBS_MAX_CODE-q->cobsCode;
+      if (maxRun>len) {
+         maxRun = len;
+      }
+      run    = 0;
+      while (run<maxRun && buf[run]!=COBS_DELIMITER) {
+         run++;
+      }
+      outputHdlcPutBuffer(q,buf,run);
+      q->cobsCode                                    += run;
+      buf   += run;
+      len   -= run;
+      if (q->cobsCode==COBS_MAX_CODE) {
+         outputCobsCode(q);
+         outputCobsBlock(q);
+      } else if (len>0) {
+         // a null byte ends the block
+         outputCobsCode(q);
+         outputCobsBlock(q);
+         buf++;
+         len--;
+      }
+   }
+}
+/**
+\brief End the outgoing COBS frame, after its CRC.
+*/
+inline void outputCobsEnd(openserial_outputQueue_t* q) {
+   outputCobsCode(q);
+   outputHdlcPut(q,COBS_DELIMITER);
 }
+
+#endif
+
+//===== uart (output)
+
 /**
-\brief Add a byte to the incoming HDLC frame.
+\brief Initialize an output queue.
 
-\todo escape 0x7e and 0x7d.
+\param[in] queueId Which queue, one of OUTPUT_QUEUE_*.
+\param[in] buf     Its output buffer.
+\param[in] size    The size of buf, a power of two.
+\param[in] budget  Bytes it may queue per output window, 0 for no limit.
 */
-inline void inputHdlcWrite(uint8_t b) {
-   if (b==HDLC_ESCAPE) {
-      openserial_vars.inputEscaping = TRUE;
-   } else {
-      if (openserial_vars.inputEscaping==TRUE) {
-         b                             = b^HDLC_ESCAPE_MASK;
-         openserial_vars.inputEscaping = FALSE;
+void outputQueueInit(uint8_t queueId, volatile uint8_t* buf, uint16_t size, uint16_t budget) {
+   openserial_outputQueue_t* q;
+   
+   q                 = &openserial_vars.outputQueue[queueId];
+   q->busy           = FALSE;
+   q->idxW           = 0;
+   q->idxR           = 0;
+   q->mask           = size-1;
+   q->budget         = budget;
+   q->buf            = buf;
+}
+
+/**
+\brief Hand the next bytes of the output queues to the UART.
+
+Between batches, this picks the highest priority queue which holds frames, and
+the batch is all the frames it holds. With UART_HAS_WRITEBUFFER, the bytes
+handed to the UART are the rest of the batch, or up to the end of the queue's
+buffer if they wrap around; otherwise, a single byte. They stay in the output
+buffer until outputWriteDone().
+
+\returns TRUE if bytes were handed to the UART, FALSE if there are none.
+*/
+inline bool outputWriteNext() {
+   openserial_outputQueue_t* q;
+   outputBufIdx_t            idxR;
+   outputBufIdx_t            idxEnd;
+   uint8_t                   i;
+   
+   if (openserial_vars.outputTxQueue==OUTPUT_QUEUE_MAX) {
+      for (i=0;i<OUTPUT_QUEUE_MAX;i++) {
+         q = &openserial_vars.outputQueue[i];
+         if (q->idxR!=q->idxW) {
+            break;
+         }
       }
-      
-      // add byte to input buffer
-      openserial_vars.inputBuf[openserial_vars.inputBufFill] = b;
-      openserial_vars.inputBufFill++;
-      
-      // iterate through CRC calculator
-      openserial_vars.inputCrc = crcIteration(openserial_vars.inputCrc,b);
+      if (i==OUTPUT_QUEUE_MAX) {
+         return FALSE;
+      }
+      openserial_vars.outputTxQueue  = i;
+      openserial_vars.outputTxEnd    = q->idxW;
    }
+   q      = &openserial_vars.outputQueue[openserial_vars.outputTxQueue];
+   idxR   = q->idxR;
+   idxEnd = openserial_vars.outputTxEnd;
+#ifdef UART_HAS_WRITEBUFFER
+   if (idxEnd>idxR) {
+      openserial_vars.outputBufLenTx = idxEnd-idxR;
+   } else {
+      openserial_vars.outputBufLenTx = q->mask+1-idxR;
+   }
+   uart_writeBuffer((uint8_t*)&q->buf[idxR],openserial_vars.outputBufLenTx);
+#else
+   openserial_vars.outputBufLenTx    = 1;
+   uart_writeByte(q->buf[idxR]);
+#endif
+   return TRUE;
 }
+
 /**
-\brief Finalize the incoming HDLC frame.
+\brief Release the bytes the UART sent, for producers to reuse.
 */
-inline void inputHdlcClose() {
+inline void outputWriteDone() {
+   openserial_outputQueue_t* q;
    
-   // verify the validity of the frame
-   if (openserial_vars.inputCrc==HDLC_CRCGOOD) {
-      // the CRC is correct
-      
-      // remove the CRC from the input buffer
-      openserial_vars.inputBufFill    -= 2;
+   if (openserial_vars.outputTxQueue==OUTPUT_QUEUE_MAX) {
+      return;
+   }
+   q                                 = &openserial_vars.outputQueue[openserial_vars.outputTxQueue];
+   q->idxR                           = (q->idxR+openserial_vars.outputBufLenTx)&q->mask;
+   openserial_vars.outputBufLenTx    = 0;
+   if (q->idxR==openserial_vars.outputTxEnd) {
+      // batch sent, pick a queue again
+      openserial_vars.outputTxQueue  = OUTPUT_QUEUE_MAX;
+   }
+}
+
+//===== uart
+
+/**
+\brief Clear the pending UART interrupts, and enable them.
+
+In full-duplex mode, the UART keeps sending and receiving across slots: a
+pending interrupt may then be a transfer completing, so this is only done the
+first time. In half-duplex mode, a uart_writeBuffer() transfer may also outlive
+its output window, see openserial_stop().
+*/
+void openserial_startUart() {
+#if SERIAL_FULL_DUPLEX
+   if (openserial_vars.uartStarted==TRUE) {
+      return;
+   }
+   openserial_vars.uartStarted = TRUE;
+#endif
+   if (openserial_vars.outputBufLenTx==0) {
+      // else the UART is still sending, its TX interrupt is to come
+      uart_clearTxInterrupts();
+   }
+   uart_clearRxInterrupts();      // clear possible pending interrupts
+   uart_enableInterrupts();       // Enable USCI_A1 TX & RX interrupt
+}
+
+//===== command FIFO (input)
+
+/**
+\brief Number of bytes of the frame at the head of the command FIFO, command
+   byte included, 0 if the FIFO is empty.
+*/
+inline uint16_t inputFifoHeadFill() {
+   if (openserial_vars.inputFifoR==openserial_vars.inputFifoW) {
+      return 0;
+   }
+   return openserial_vars.inputBufFill[openserial_vars.inputFifoR&SERIAL_INPUT_FIFO_MASK];
+}
+/**
+\brief The frame at the head of the command FIFO.
+*/
+inline uint8_t* inputFifoHead() {
+   return openserial_vars.inputBuf[openserial_vars.inputFifoR&SERIAL_INPUT_FIFO_MASK];
+}
+/**
+\brief Whether all the slots of the command FIFO hold a frame.
+*/
+inline bool inputFifoFull() {
+   return (uint8_t)(openserial_vars.inputFifoW-openserial_vars.inputFifoR)>=SERIAL_INPUT_FIFO_DEPTH;
+}
+/**
+\brief Drop the frame at the head of the command FIFO.
+*/
+inline void inputFifoPop() {
+   openserial_vars.inputFifoR++;
+}
+/**
+\brief Decode the next frame in the free slot of the command FIFO.
+
+If there is none, the frame is dropped, as overflowing an empty buffer, and
+counted in numInputFifoFull rather than numInputOverflow.
+*/
+inline void inputDecoderNext() {
+   if (inputFifoFull()==TRUE) {
+      openserial_vars.inputDecoder.buf  = openserial_vars.inputBuf[0];
+      openserial_vars.inputDecoder.size = 0;
    } else {
-      // the CRC is incorrect
-      
-      // drop the incoming fram
-      openserial_vars.inputBufFill     = 0;
+      openserial_vars.inputDecoder.buf  = openserial_vars.inputBuf[openserial_vars.inputFifoW&SERIAL_INPUT_FIFO_MASK];
+      openserial_vars.inputDecoder.size = SERIAL_INPUT_BUFFER_SIZE;
    }
 }
+/**
+\brief Dispatch the frames of the command FIFO to their command handlers.
+
+Stops at a frame a handler borrowed, see openserial_borrowInputBuffer().
+*/
+void inputDispatch() {
+   uint16_t inputBufFill;
+   uint8_t  cmdByte;
+   bool     borrowed;
+   INTERRUPT_DECLARATION();
+   
+   while (1) {
+      DISABLE_INTERRUPTS();
+      inputBufFill = inputFifoHeadFill();
+      borrowed     = openserial_vars.inputBufBorrowed;
+      ENABLE_INTERRUPTS();
+   
+      // a frame lent out was already dispatched
+      if (inputBufFill==0 || borrowed==TRUE) {
+         break;
+      }
+   
+      cmdByte = inputFifoHead()[0];
+      switch (cmdByte) {
+         case SERFRAME_PC2MOTE_SETROOT:
+            idmanager_triggerAboutRoot();
+            break;
+         case SERFRAME_PC2MOTE_SETBRIDGE:
+            idmanager_triggerAboutBridge();
+            break;
+         case SERFRAME_PC2MOTE_DATA:
+            openbridge_triggerData();
+            break;
+         case SERFRAME_PC2MOTE_TRIGGERTCPINJECT:
+            tcpinject_trigger();
+            break;
+         case SERFRAME_PC2MOTE_TRIGGERUDPINJECT:
+            udpinject_trigger();
+            break;
+         case SERFRAME_PC2MOTE_TRIGGERICMPv6ECHO:
+            icmpv6echo_trigger();
+            break;
+         case SERFRAME_PC2MOTE_TRIGGERSERIALECHO:
+            openserial_echo(&(inputFifoHead()[1]),inputBufFill-1);
+            break;
+         case SERFRAME_PC2MOTE_SETFRAMING:
+            inputSetFraming(&(inputFifoHead()[1]),inputBufFill-1);
+            break;
+         default:
+            openserial_printError(COMPONENT_OPENSERIAL,ERR_UNSUPPORTED_COMMAND,
+                                  (errorparameter_t)cmdByte,
+                                  (errorparameter_t)0);
+            break;
+      }
+   
+      DISABLE_INTERRUPTS();
+      if (openserial_vars.inputBufBorrowed==FALSE) {
+         inputFifoPop();
+      }
+      ENABLE_INTERRUPTS();
+   }
+}
+/**
+\brief Switch the framing of the frames printed from now on, as the PC asks.
+
+\param[in] buf The command, past its command byte: one of SERIAL_FRAMING_*.
+\param[in] len The number of bytes of the command.
+*/
+void inputSetFraming(uint8_t* buf, uint16_t len) {
+#if SERIAL_COBS
+   if (len==1 && (buf[0]==SERIAL_FRAMING_HDLC || buf[0]==SERIAL_FRAMING_COBS)) {
+      openserial_vars.framing = buf[0];
+   }
+#endif
+   // tell the PC which framing it gets, the old one if it asked for another
+   openserial_printFraming();
+}
 
 //=========================== interrupt handlers ==============================
 
@@ -534,14 +1315,16 @@ void isr_openserial_tx() {
          }
          break;
       case MODE_OUTPUT:
-         if (openserial_vars.outputBufIdxW==openserial_vars.outputBufIdxR) {
-            openserial_vars.outputBufFilled = FALSE;
-         }
-         if (openserial_vars.outputBufFilled) {
-            uart_writeByte(openserial_vars.outputBuf[openserial_vars.outputBufIdxR++]);
-         }
+         outputWriteDone();
+         outputWriteNext();
          break;
       case MODE_OFF:
+         if (openserial_vars.outputBufLenTx>0) {
+            // the end of a transfer which outlived its output window
+            outputWriteDone();
+            uart_disableInterrupts();
+         }
+         break;
       default:
          break;
    }
@@ -549,86 +1332,72 @@ void isr_openserial_tx() {
 
 // executed in ISR, called from scheduler.c
 void isr_openserial_rx() {
-   uint8_t rxbyte;
-   uint8_t inputBufFill;
+   uint8_t           rxbyte;
+   openhdlc_decode_t outcome;
    
+#if SERIAL_FULL_DUPLEX==0
    // stop if I'm not in input mode
    if (openserial_vars.mode!=MODE_INPUT) {
       return;
    }
+#endif
    
    // read byte just received
    rxbyte = uart_readByte();
-   //keep lenght
-   inputBufFill=openserial_vars.inputBufFill;
-   
-   if        (
-                openserial_vars.busyReceiving==FALSE  &&
-                openserial_vars.lastRxByte==HDLC_FLAG &&
-                rxbyte!=HDLC_FLAG
-              ) {
-      // start of frame
-      
-      // I'm now receiving
-      openserial_vars.busyReceiving         = TRUE;
-      
-      // create the HDLC frame
-      inputHdlcOpen();
-      
-      // add the byte just received
-      inputHdlcWrite(rxbyte);
-   } else if (
-                openserial_vars.busyReceiving==TRUE   &&
-                rxbyte!=HDLC_FLAG
-             ) {
-      // middle of frame
-      
-      // add the byte just received
-      inputHdlcWrite(rxbyte);
-      if (openserial_vars.inputBufFill+1>SERIAL_INPUT_BUFFER_SIZE){
-         // input buffer overflow
-         openserial_printError(COMPONENT_OPENSERIAL,ERR_INPUT_BUFFER_OVERFLOW,
-                               (errorparameter_t)0,
-                               (errorparameter_t)0);
-         openserial_vars.inputBufFill       = 0;
-         openserial_vars.busyReceiving      = FALSE;
-         openserial_stop();
-      }
-   } else if (
-                openserial_vars.busyReceiving==TRUE   &&
-                rxbyte==HDLC_FLAG
-              ) {
-         // end of frame
-         
-         // finalize the HDLC frame
-         inputHdlcClose();
-         
-         if (openserial_vars.inputBufFill==0){
-            // invalid HDLC frame
-            openserial_printError(COMPONENT_OPENSERIAL,ERR_WRONG_CRC_INPUT,
-                                  (errorparameter_t)inputBufFill,
-                                  (errorparameter_t)0);
-         
+   
+   if (
+         openserial_vars.inputDecoder.complete==TRUE ||
+         (openserial_vars.inputDecoder.len==0 && openserial_vars.inputDecoder.overflow==FALSE)
+      ) {
+      // nothing of the next frame kept or dropped yet, decode it in the next
+      // free slot; a frame being dropped for a full FIFO stays dropped
+      inputDecoderNext();
+   }
+   openhdlc_decode(&openserial_vars.inputDecoder,&rxbyte,1,&outcome);
+   
+   switch (outcome) {
+      case HDLC_DECODE_BUSY:
+         return;
+      case HDLC_DECODE_FRAME:
+         if (openserial_vars.inputDecoder.len==0) {
+            // no command byte
+            openserial_dbg.numInputBadCrc++;
+            break;
          }
-         
-         openserial_vars.busyReceiving      = FALSE;
-         openserial_stop();
+         openserial_vars.inputBufFill[openserial_vars.inputFifoW&SERIAL_INPUT_FIFO_MASK] = openserial_vars.inputDecoder.len;
+         openserial_vars.inputFifoW++;
+         openserial_dbg.numInputFrames++;
+#if SERIAL_FULL_DUPLEX
+         scheduler_push_task_coalesce(task_openserialDispatch,TASKPRIO_BUTTON);
+#endif
+         break;
+      case HDLC_DECODE_BADCRC:
+         openserial_dbg.numInputBadCrc++;
+         break;
+      case HDLC_DECODE_OVERFLOW:
+      default:
+         if (openserial_vars.inputDecoder.size==0) {
+            openserial_dbg.numInputFifoFull++;
+         } else {
+            openserial_dbg.numInputOverflow++;
+         }
+         break;
    }
    
-   openserial_vars.lastRxByte = rxbyte;
+#if SERIAL_FULL_DUPLEX==0
+   // in half-duplex mode, the input window ends with the frame
+   openserial_stop();
+#endif
 }
 
 //======== SERIAL ECHO =============
 
-void openserial_echo(uint8_t* buf, uint8_t bufLen){
-   INTERRUPT_DECLARATION();
-   // echo back what you received
-   openserial_printData(
-      buf,
-      bufLen
-   );
-   
-    DISABLE_INTERRUPTS();
-    openserial_vars.inputBufFill = 0;
-    ENABLE_INTERRUPTS();
+void openserial_echo(uint8_t* buf, uint16_t bufLen){
+   // echo back what you received, if it fits a data frame
+   if (bufLen<=0xff) {
+      openserial_printData(
+         buf,
+         (uint8_t)bufLen
+      );
+   }
 }
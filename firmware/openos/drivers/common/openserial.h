@@ -8,6 +8,7 @@
 #define __OPENSERIAL_H
 
 #include "openwsn.h"
+#include "openhdlc.h"
 
 /**
 \addtogroup cross-layers
@@ -19,26 +20,179 @@
 //=========================== define ==========================================
 
 /**
-\brief Number of bytes of the serial output buffer, in bytes.
+\brief Number of bytes of the serial output buffers, in bytes.
 
-\warning should be exactly 256 so wrap-around on the index does not require
-         the use of a slow modulo operator.
+There is one output buffer per class of frames, see OUTPUT_QUEUE_*:
+- SERIAL_OUTPUT_CONTROL_BUFFER_SIZE for request and framing frames,
+- SERIAL_OUTPUT_ERROR_BUFFER_SIZE for critical and error frames,
+- SERIAL_OUTPUT_BUFFER_SIZE for data frames,
+- SERIAL_OUTPUT_STATUS_BUFFER_SIZE for status and info frames.
+
+One byte of each is always left unused, to tell a full buffer from an empty one.
+
+\warning Must be powers of two, so wrap-around on the index does not require
+         the use of a slow modulo operator, and not greater than 32768.
+*/
+#ifndef SERIAL_OUTPUT_BUFFER_SIZE
+#define SERIAL_OUTPUT_BUFFER_SIZE 256
+#endif
+#ifndef SERIAL_OUTPUT_CONTROL_BUFFER_SIZE
+#define SERIAL_OUTPUT_CONTROL_BUFFER_SIZE 32
+#endif
+#ifndef SERIAL_OUTPUT_ERROR_BUFFER_SIZE
+#define SERIAL_OUTPUT_ERROR_BUFFER_SIZE 64
+#endif
+#ifndef SERIAL_OUTPUT_STATUS_BUFFER_SIZE
+#define SERIAL_OUTPUT_STATUS_BUFFER_SIZE 128
+#endif
+
+#if (SERIAL_OUTPUT_BUFFER_SIZE&(SERIAL_OUTPUT_BUFFER_SIZE-1))!=0 || SERIAL_OUTPUT_BUFFER_SIZE>32768
+#error SERIAL_OUTPUT_BUFFER_SIZE must be a power of two, not greater than 32768
+#endif
+#if (SERIAL_OUTPUT_CONTROL_BUFFER_SIZE&(SERIAL_OUTPUT_CONTROL_BUFFER_SIZE-1))!=0 || SERIAL_OUTPUT_CONTROL_BUFFER_SIZE>32768
+#error SERIAL_OUTPUT_CONTROL_BUFFER_SIZE must be a power of two, not greater than 32768
+#endif
+#if (SERIAL_OUTPUT_ERROR_BUFFER_SIZE&(SERIAL_OUTPUT_ERROR_BUFFER_SIZE-1))!=0 || SERIAL_OUTPUT_ERROR_BUFFER_SIZE>32768
+#error SERIAL_OUTPUT_ERROR_BUFFER_SIZE must be a power of two, not greater than 32768
+#endif
+#if (SERIAL_OUTPUT_STATUS_BUFFER_SIZE&(SERIAL_OUTPUT_STATUS_BUFFER_SIZE-1))!=0 || SERIAL_OUTPUT_STATUS_BUFFER_SIZE>32768
+#error SERIAL_OUTPUT_STATUS_BUFFER_SIZE must be a power of two, not greater than 32768
+#endif
+
+/**
+\brief Number of bytes a class of frames may queue per output window, 0 for no
+   limit.
+
+An output window runs from one openserial_startOutput() to the next. A frame
+which would exceed its class' budget is dropped, unless it is the first of the
+window, so frames larger than the budget still get through. Request and
+framing frames have no budget.
 */
-#define SERIAL_OUTPUT_BUFFER_SIZE 256 // leave at 256!
+#ifndef SERIAL_OUTPUT_ERROR_BUDGET
+#define SERIAL_OUTPUT_ERROR_BUDGET    0
+#endif
+#ifndef SERIAL_OUTPUT_DATA_BUDGET
+#define SERIAL_OUTPUT_DATA_BUDGET     0
+#endif
+#ifndef SERIAL_OUTPUT_STATUS_BUDGET
+#define SERIAL_OUTPUT_STATUS_BUDGET   64
+#endif
 
 /**
 \brief Number of bytes of the serial input buffer, in bytes.
 
-\warning Do not pick a number greater than 255, since its filling level is
-         encoded by a single byte in the code.
+The largest frame received from the PC holds SERIAL_INPUT_BUFFER_SIZE bytes,
+command byte and CRC included. There is one input buffer per slot of the
+command FIFO. Frames of more than 255 data bytes are read with
+openserial_getInputBuffer16().
+
+\warning Do not pick a number greater than 65535, since its filling level is
+         encoded on 16 bits in the code.
 */
+#ifndef SERIAL_INPUT_BUFFER_SIZE
 #define SERIAL_INPUT_BUFFER_SIZE  200
+#endif
+
+#if SERIAL_INPUT_BUFFER_SIZE>65535
+#error SERIAL_INPUT_BUFFER_SIZE must not be greater than 65535
+#endif
+
+/**
+\brief Whether openserial runs full-duplex, 0 (default) for the half-duplex
+   mode.
+
+In full-duplex mode, once openserial_startInput() or openserial_startOutput()
+is called, the UART keeps receiving and sending. Frames from the PC are decoded
+as they arrive, queued in the command FIFO, and dispatched by a task; frames to
+the PC are sent as soon as they are printed. openserial_startInput() still
+sends a request frame, for PCs which only send commands when asked, and
+openserial_stop() does nothing.
+
+In half-duplex mode, the UART only runs between openserial_startInput() or
+openserial_startOutput() and openserial_stop(). An input window sends a request
+frame, receives at most one frame from the PC, and dispatches it.
+
+Full-duplex mode needs a PC which accepts commands while the mote prints, and a
+board whose UART may stay on outside of the serial slots.
+*/
+#ifndef SERIAL_FULL_DUPLEX
+#define SERIAL_FULL_DUPLEX 0
+#endif
+
+/**
+\brief Number of frames from the PC the command FIFO holds.
+
+\warning Must be a power of two, not greater than 128.
+*/
+#ifndef SERIAL_INPUT_FIFO_DEPTH
+#if SERIAL_FULL_DUPLEX
+#define SERIAL_INPUT_FIFO_DEPTH 2
+#else
+#define SERIAL_INPUT_FIFO_DEPTH 1
+#endif
+#endif
+
+#if (SERIAL_INPUT_FIFO_DEPTH&(SERIAL_INPUT_FIFO_DEPTH-1))!=0 || SERIAL_INPUT_FIFO_DEPTH>128
+#error SERIAL_INPUT_FIFO_DEPTH must be a power of two, not greater than 128
+#endif
+
+#define SERIAL_INPUT_FIFO_MASK (SERIAL_INPUT_FIFO_DEPTH-1)
+
+/**
+\brief Number of output windows between two status keyframes, 0 (default) to
+   print every status element every time.
+
+If not 0, openserial_printStatus() only prints a status element if it changed
+since it was last printed. Every SERIAL_STATUS_KEYFRAME_PERIOD output windows,
+it forgets what it printed, so the next round of status elements is printed
+whole, for the PC to resync.
+
+\warning A PC which connects, or loses a status frame, may show stale status
+         for up to SERIAL_STATUS_KEYFRAME_PERIOD output windows. Keep it low,
+         e.g. 16, unless the PC knows about it.
+*/
+#ifndef SERIAL_STATUS_KEYFRAME_PERIOD
+#define SERIAL_STATUS_KEYFRAME_PERIOD 0
+#endif
+
+/**
+\brief Number of rows of STATUS_SCHEDULE and STATUS_NEIGHBORS tracked.
+
+These status elements are printed one row at a time, the row number in their
+first byte. Changes are tracked per row; rows past this number are always
+printed.
+*/
+#ifndef SERIAL_STATUS_NUM_ROWS
+#define SERIAL_STATUS_NUM_ROWS        16
+#endif
+
+/**
+\brief Whether openserial can frame its output with COBS, 0 for HDLC only.
+
+Output frames are HDLC frames until the PC asks for another framing, with a
+SERFRAME_PC2MOTE_SETFRAMING command holding one of SERIAL_FRAMING_*. The mote
+answers with a SERFRAME_MOTE2PC_FRAMING frame holding the framing of its
+output frames from then on; a mote built without COBS answers
+SERIAL_FRAMING_HDLC. Frames from the PC are always HDLC frames.
+
+A COBS frame is the frame and its CRC, COBS encoded, between two COBS_DELIMITER
+bytes. COBS adds one byte per 254 bytes of frame, whatever the bytes, where
+HDLC escaping doubles the size of a frame of HDLC_FLAG and HDLC_ESCAPE bytes.
+Frames queued before the switch keep their framing; their first byte,
+HDLC_FLAG or COBS_DELIMITER, tells the PC which one.
+*/
+#ifndef SERIAL_COBS
+#define SERIAL_COBS                   0
+#endif
+
+#define COBS_DELIMITER                0x00
+#define COBS_MAX_CODE                 0xff   // a block of 254 non-zero bytes
 
 /// Modes of the openserial module.
 enum {
    MODE_OFF    = 0, ///< The module is off, no serial activity.
    MODE_INPUT  = 1, ///< The serial is listening or receiving bytes.
-   MODE_OUTPUT = 2  ///< The serial is transmitting bytes.
+   MODE_OUTPUT = 2  ///< The serial is transmitting bytes, and receiving in full-duplex mode.
 };
 
 // frames sent mote->PC
@@ -48,6 +202,8 @@ enum {
 #define SERFRAME_MOTE2PC_ERROR              ((uint8_t)'E')
 #define SERFRAME_MOTE2PC_CRITICAL           ((uint8_t)'C')
 #define SERFRAME_MOTE2PC_REQUEST            ((uint8_t)'R')
+#define SERFRAME_MOTE2PC_TRACE              ((uint8_t)'T')
+#define SERFRAME_MOTE2PC_FRAMING            ((uint8_t)'F')
 
 // frames sent PC->mote
 #define SERFRAME_PC2MOTE_SETROOT            ((uint8_t)'R')
@@ -57,32 +213,142 @@ enum {
 #define SERFRAME_PC2MOTE_TRIGGERUDPINJECT   ((uint8_t)'U')
 #define SERFRAME_PC2MOTE_TRIGGERICMPv6ECHO  ((uint8_t)'E')
 #define SERFRAME_PC2MOTE_TRIGGERSERIALECHO  ((uint8_t)'S')
+#define SERFRAME_PC2MOTE_SETFRAMING         ((uint8_t)'F')
+
+/// Framings of the frames sent mote->PC.
+enum {
+   SERIAL_FRAMING_HDLC              = 0, ///< HDLC flags and escaping
+   SERIAL_FRAMING_COBS              = 1, ///< COBS, if SERIAL_COBS
+};
+
+/// Output queues, one per class of frames, highest priority first.
+enum {
+   OUTPUT_QUEUE_CONTROL             = 0, ///< request and framing frames
+   OUTPUT_QUEUE_ERROR               = 1, ///< critical and error frames
+   OUTPUT_QUEUE_DATA                = 2, ///< data frames
+   OUTPUT_QUEUE_STATUS              = 3, ///< status and info frames
+   OUTPUT_QUEUE_MAX,                     ///< number of output queues, or none
+};
+
+/// Status elements of the drivers and kernel, numbered after the stack's ones.
+enum {
+   STATUS_SCHEDULER                 = STATUS_MAX,
+   STATUS_SCHEDULERPROFILE,         ///< only printed if SCHEDULER_PROFILING
+   STATUS_OPENTIMERS,
+   STATUS_OPENSERIAL,
+#ifdef OPENTRACE_ENABLED
+   STATUS_OPENTRACE,
+#endif
+   STATUS_LAST,                     ///< number of status elements openserial cycles through
+};
 
 //=========================== typedef =========================================
 
+/// Index in an output buffer, read or written in a single memory access.
+#if SERIAL_OUTPUT_BUFFER_SIZE>256 || SERIAL_OUTPUT_CONTROL_BUFFER_SIZE>256 || SERIAL_OUTPUT_ERROR_BUFFER_SIZE>256 || SERIAL_OUTPUT_STATUS_BUFFER_SIZE>256
+typedef uint16_t outputBufIdx_t;
+#else
+typedef uint8_t  outputBufIdx_t;
+#endif
+
 //=========================== module variables ================================
 
+/**
+\brief Output queue of one class of frames.
+
+Each output buffer is a single-producer single-consumer ring. The code printing
+a frame is the producer, and only writes idxW; isr_openserial_tx() is the
+consumer, and only writes idxR. The producer writes a frame past idxW, and only
+moves idxW past it once the whole frame fits, so the consumer never sees part
+of a frame, and neither needs to disable interrupts. The consumer only moves
+idxR past the bytes it handed to the UART once they are sent.
+
+A frame printed from an interrupt handler which interrupted the printing of
+another frame of the same class can not be written, and is dropped. Frames of
+different classes go to different buffers, so an error printed from an
+interrupt handler gets through whatever it interrupted.
+*/
+typedef struct {
+   // producer
+   volatile bool           busy;                   // is a frame being written?
+   bool                    frameOverflow;          // frame being written does not fit
+   outputBufIdx_t          frameIdxW;              // end of the frame being written
+   uint16_t                crc;
+   uint16_t                numBytesWindow;         // bytes queued this output window
+#if SERIAL_COBS
+   uint8_t                 framing;                // framing of the frame being written
+   outputBufIdx_t          cobsCodeIdx;            // where the code of the current COBS block goes
+   uint8_t                 cobsCode;               // code of the current COBS block, so far
+#endif
+   volatile outputBufIdx_t idxW;                   // written by the producer only
+   // consumer
+   volatile outputBufIdx_t idxR;                   // written by the consumer only
+   // configuration
+   outputBufIdx_t          mask;                   // size of buf, minus one
+   uint16_t                budget;                 // bytes per output window, 0 for no limit
+   volatile uint8_t*       buf;
+} openserial_outputQueue_t;
+
+/**
+\brief Openserial state.
+
+The consumer sends the output queues by priority, OUTPUT_QUEUE_CONTROL first. It
+picks the highest priority queue which holds frames, then sends all the frames
+that queue held at that time before picking again, so frames are never
+interleaved, and an error frame waits for at most one batch of lower priority
+frames.
+*/
 typedef struct {
    // admin
    uint8_t    mode;
    uint8_t    debugPrintCounter;
+#if SERIAL_FULL_DUPLEX
+   bool       uartStarted;                                   // UART interrupts enabled, see openserial_startUart()
+#endif
+#if SERIAL_COBS
+   uint8_t    framing;                                       // framing of the frames printed, SERIAL_FRAMING_*
+#endif
+   // status, 0 if not printed since the last keyframe
+#if SERIAL_STATUS_KEYFRAME_PERIOD>0
+   uint16_t   statusCrc[STATUS_LAST];                        // CRC of each status element printed
+   uint16_t   statusRowCrc[2][SERIAL_STATUS_NUM_ROWS];       // same, per schedule and neighbor row
+   uint16_t   statusWindowCounter;                           // output windows since the last keyframe
+#endif
+   bool       statusUnchanged;                               // last status element not printed, unchanged
    // input
    uint8_t    reqFrame[1+1+2+1]; // flag (1B), command (2B), CRC (2B), flag (1B)
    uint8_t    reqFrameIdx;
-   uint8_t    lastRxByte;
-   bool       busyReceiving;
-   bool       inputEscaping;
-   uint16_t   inputCrc;
-   uint8_t    inputBufFill;
-   uint8_t    inputBuf[SERIAL_INPUT_BUFFER_SIZE];
+   openhdlc_decoder_t inputDecoder;
+   volatile uint8_t   inputFifoW;       // written by isr_openserial_rx() only
+   volatile uint8_t   inputFifoR;       // written by the command dispatch only
+   bool       inputBufBorrowed;  // head of the FIFO lent out, see openserial_borrowInputBuffer()
+   uint16_t   inputBufFill[SERIAL_INPUT_FIFO_DEPTH];
+   uint8_t    inputBuf[SERIAL_INPUT_FIFO_DEPTH][SERIAL_INPUT_BUFFER_SIZE];
    // output
-   bool       outputBufFilled;
-   uint16_t   outputCrc;
-   uint8_t    outputBufIdxW;
-   uint8_t    outputBufIdxR;
-   uint8_t    outputBuf[SERIAL_OUTPUT_BUFFER_SIZE];
+   openserial_outputQueue_t outputQueue[OUTPUT_QUEUE_MAX];
+   uint8_t                  outputTxQueue;         // queue being sent, OUTPUT_QUEUE_MAX if none
+   outputBufIdx_t           outputTxEnd;           // end of the batch being sent
+   uint16_t                 outputBufLenTx;        // bytes handed to the UART
+   volatile uint8_t         outputBufControl[SERIAL_OUTPUT_CONTROL_BUFFER_SIZE];
+   volatile uint8_t         outputBufError[SERIAL_OUTPUT_ERROR_BUFFER_SIZE];
+   volatile uint8_t         outputBufData[SERIAL_OUTPUT_BUFFER_SIZE];
+   volatile uint8_t         outputBufStatus[SERIAL_OUTPUT_STATUS_BUFFER_SIZE];
 } openserial_vars_t;
 
+/// Output counters, per output queue.
+typedef struct {
+   uint16_t   numOutputFrames[OUTPUT_QUEUE_MAX];   // frames written to the output buffer
+   uint16_t   numDroppedFull[OUTPUT_QUEUE_MAX];    // frames dropped, output buffer full
+   uint16_t   numDroppedBusy[OUTPUT_QUEUE_MAX];    // frames dropped, another one being written
+   uint16_t   numDroppedBudget[OUTPUT_QUEUE_MAX];  // frames dropped, over the window's budget
+   uint16_t   numStatusUnchanged;                  // status elements not printed, unchanged
+   uint16_t   numInputFrames;                      // frames received from the PC
+   uint16_t   numInputBadCrc;                      // frames received with a wrong CRC
+   uint16_t   numInputOverflow;                    // frames larger than the input buffer
+   uint16_t   numInputAborted;                     // frames cut by the end of the input window
+   uint16_t   numInputFifoFull;                    // frames dropped or input windows skipped, command FIFO full
+} openserial_dbg_t;
+
 //=========================== prototypes ======================================
 
 void    openserial_init();
@@ -97,13 +363,25 @@ owerror_t openserial_printCritical(uint8_t calling_component, uint8_t error_code
                               errorparameter_t arg1,
                               errorparameter_t arg2);
 owerror_t openserial_printData(uint8_t* buffer, uint8_t length);
+#ifdef OPENTRACE_ENABLED
+owerror_t openserial_printTrace(uint8_t* buffer, uint8_t length);
+#endif
 uint8_t openserial_getNumDataBytes();
 uint8_t openserial_getInputBuffer(uint8_t* bufferToWrite, uint8_t maxNumBytes);
+uint16_t openserial_getNumDataBytes16();
+uint16_t openserial_getInputBuffer16(uint8_t* bufferToWrite, uint16_t maxNumBytes);
+uint8_t* openserial_borrowInputBuffer(uint16_t* len);
+void    openserial_releaseInputBuffer();
 void    openserial_startInput();
 void    openserial_startOutput();
 void    openserial_stop();
 bool    debugPrint_outBufferIndexes();
-void    openserial_echo(uint8_t* but, uint8_t bufLen);
+bool    debugPrint_openserial();
+bool    debugPrint_scheduler();
+#ifdef SCHEDULER_PROFILING
+bool    debugPrint_schedulerProfile();
+#endif
+void    openserial_echo(uint8_t* but, uint16_t bufLen);
 
 // interrupt handlers
 void    isr_openserial_rx();
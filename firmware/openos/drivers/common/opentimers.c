@@ -11,17 +11,36 @@ at most MAX_NUM_TIMERS timers.
 #include "opentimers.h"
 #include "bsp_timer.h"
 #include "leds.h"
+#include "openserial.h"
+#include "opentrace.h"
 
 //=========================== define ==========================================
 
 //=========================== variables =======================================
 
 opentimers_vars_t opentimers_vars;
+opentimers_dbg_t  opentimers_dbg;
 //uint32_t counter; //counts the elapsed time.
 
 //=========================== prototypes ======================================
 
-void opentimers_timer_callback();
+void     opentimers_timer_callback();
+uint32_t opentimers_toTicks(uint32_t duration, time_type_t timetype);
+void     opentimers_fireExpired();
+void     opentimers_scheduleNext();
+void     opentimers_scheduleAt(uint32_t target);
+void     opentimers_update();
+uint32_t opentimers_now();
+uint32_t opentimers_counterTime();
+// heaps
+uint32_t opentimers_heapKey(uint8_t h, uint8_t i);
+bool     opentimers_isEarlier(uint8_t h, uint8_t i, uint8_t j);
+void     opentimers_heapSwap(uint8_t h, uint8_t i, uint8_t j);
+void     opentimers_heapUp(uint8_t h, uint8_t i);
+void     opentimers_heapDown(uint8_t h, uint8_t i);
+void     opentimers_heapFix(uint8_t h, uint8_t i);
+void     opentimers_heapInsert(opentimer_id_t id);
+void     opentimers_heapRemove(opentimer_id_t id);
 
 //=========================== public ==========================================
 
@@ -32,30 +51,45 @@ Initializes data structures and hardware timer.
  */
 void opentimers_init(){
    uint8_t i;
+   uint8_t h;
 
    // initialize local variables
-   opentimers_vars.running=FALSE;
+   opentimers_vars.isFiring       = FALSE;
+   opentimers_vars.numRunning     = 0;
+   opentimers_vars.currentTime    = 0;
+   opentimers_vars.counterOrigin  = 0;
+   opentimers_vars.nextTimeout    = 0;
    for (i=0;i<MAX_NUM_TIMERS;i++) {
       opentimers_vars.timersBuf[i].period_ticks       = 0;
-      opentimers_vars.timersBuf[i].ticks_remaining    = 0;
+      opentimers_vars.timersBuf[i].slack_ticks        = 0;
+      opentimers_vars.timersBuf[i].expiry             = 0;
+      opentimers_vars.timersBuf[i].remaining_ticks    = 0;
       opentimers_vars.timersBuf[i].type               = TIMER_ONESHOT;
       opentimers_vars.timersBuf[i].isrunning          = FALSE;
       opentimers_vars.timersBuf[i].callback           = NULL;
-      opentimers_vars.timersBuf[i].hasExpired         = FALSE;
+      for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+         opentimers_vars.timersBuf[i].heapIdx[h]      = i;
+         opentimers_vars.timersHeap[h][i]             = i;
+      }
    }
+   memset(&opentimers_dbg,0,sizeof(opentimers_dbg_t));
 
    // set callback for bsp_timers module
    bsp_timer_set_callback(opentimers_timer_callback);
+
+   // start the virtual clock, with the counter at 0
+   bsp_timer_reset();
+   opentimers_scheduleNext();
 }
 
 /**
 \brief Start a timer.
 
 The timer works as follows:
-- currentTimeout is the number of ticks before the next timer expires.
+- nextTimeout is the time at which the next timer expires.
 - if a new timer is inserted, we check that it is not earlier than the soonest
 - if it is earliest, replace it
-- if not, insert it in the list
+- if not, insert it in the heap
 
 \param duration Number milli-seconds after which the timer will fire.
 \param type     The type of timer, indicating whether it's a one-shot or a period timer.
@@ -66,98 +100,87 @@ The timer works as follows:
 \returns TOO_MANY_TIMERS_ERROR if the timer could NOT be started.
  */
 opentimer_id_t opentimers_start(uint32_t duration, timer_type_t type, time_type_t timetype, opentimers_cbt callback) {
+   return opentimers_start_with_slack(duration,0,type,timetype,callback);
+}
 
-   uint8_t  id;
+/**
+\brief Start a timer which tolerates firing late.
 
-   // find an unused timer
-   for (id=0; id<MAX_NUM_TIMERS && opentimers_vars.timersBuf[id].isrunning==TRUE; id++);
+The timer may fire up to slack after duration, together with other timers, so
+that several timers cost a single wakeup. Timers expiring within the slack of
+each other are grouped into one hardware timeout, at the end of the earliest
+slack window among them.
 
-   if (id<MAX_NUM_TIMERS) {
-      // we found an unused timer
+\param duration Time after which the timer will fire.
+\param slack    Additional time the timer may wait, in the same unit.
+\param type     The type of timer, indicating whether it's a one-shot or a period timer.
+\param timetype The unit of duration and slack.
+\param callback The function to call when the timer fires.
 
-      // register the timer
-      if (timetype==TIME_MS) {
-         opentimers_vars.timersBuf[id].period_ticks      = duration*PORT_TICS_PER_MS;
-         opentimers_vars.timersBuf[id].wraps_remaining   = (duration*PORT_TICS_PER_MS/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-      } else if (timetype==TIME_TICS) {
-         opentimers_vars.timersBuf[id].period_ticks      = duration;
-         opentimers_vars.timersBuf[id].wraps_remaining   = (duration/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t  
-      } else {
-         while (1); //error
-      }
-      //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-      if(opentimers_vars.timersBuf[id].wraps_remaining==0){
-         if (timetype==TIME_MS){ 
-            opentimers_vars.timersBuf[id].ticks_remaining   = duration*PORT_TICS_PER_MS;
-         } else if (timetype==TIME_TICS) {
-            opentimers_vars.timersBuf[id].ticks_remaining   = duration;
-         } else {
-            // this should never happpen!
-   
-            // we can not print from within the drivers. Instead:
-            // blink the error LED
-            leds_error_blink();
-            // reset the board
-            board_reset();
-         }
-      }else{
-         opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-      }                                                   
-      opentimers_vars.timersBuf[id].type              = type;
-      opentimers_vars.timersBuf[id].isrunning         = TRUE;
-      opentimers_vars.timersBuf[id].callback          = callback;
-      opentimers_vars.timersBuf[id].hasExpired        = FALSE;
-
-      // re-schedule the running timer, if needed
-      if (
-            (opentimers_vars.running==FALSE)
-            ||
-            (opentimers_vars.timersBuf[id].ticks_remaining < opentimers_vars.currentTimeout)
-      ) {  
-         opentimers_vars.currentTimeout            = opentimers_vars.timersBuf[id].ticks_remaining;
-         if (opentimers_vars.running==FALSE) {
-            bsp_timer_reset();
-         }
-         bsp_timer_scheduleIn(opentimers_vars.timersBuf[id].ticks_remaining);
-      }
+\returns The id of the timer, or TOO_MANY_TIMERS_ERROR, as opentimers_start().
+ */
+opentimer_id_t opentimers_start_with_slack(uint32_t duration, uint32_t slack, timer_type_t type, time_type_t timetype, opentimers_cbt callback) {
 
-      opentimers_vars.running                         = TRUE;
+   opentimer_id_t id;
+   INTERRUPT_DECLARATION();
 
-   } else {
+   DISABLE_INTERRUPTS();
+   if (opentimers_vars.numRunning>=MAX_NUM_TIMERS) {
+      ENABLE_INTERRUPTS();
       return TOO_MANY_TIMERS_ERROR;
    }
 
+   // the first unused timer sits right after the heaps
+   id = opentimers_vars.timersHeap[OPENTIMERS_HEAP_EXPIRY][opentimers_vars.numRunning];
+
+   // register the timer
+   opentimers_vars.timersBuf[id].period_ticks      = opentimers_toTicks(duration,timetype);
+   opentimers_vars.timersBuf[id].slack_ticks       = 0;
+   if (slack>0) {
+      opentimers_vars.timersBuf[id].slack_ticks    = opentimers_toTicks(slack,timetype);
+   }
+   opentimers_vars.timersBuf[id].expiry            = opentimers_now()+
+                                                     opentimers_vars.timersBuf[id].period_ticks;
+   opentimers_vars.timersBuf[id].type              = type;
+   opentimers_vars.timersBuf[id].callback          = callback;
+   opentimers_heapInsert(id);
+
+   // re-schedule the running timer, if needed
+   opentimers_update();
+   ENABLE_INTERRUPTS();
+
    return id;
 }
 
 /**
-\brief Replace the period of a running timer.
+\brief Replace the period of a timer.
+
+The current period of a running timer keeps its start: the timer next expires
+at its previous expiry (or start) plus the new period, right away if that is
+already past. A stopped timer restarts for one new period.
  */
 void  opentimers_setPeriod(opentimer_id_t id,time_type_t timetype,uint32_t newDuration) {
-   if        (timetype==TIME_MS) {
-      opentimers_vars.timersBuf[id].period_ticks      = newDuration*PORT_TICS_PER_MS;
-      opentimers_vars.timersBuf[id].wraps_remaining   = (newDuration*PORT_TICS_PER_MS/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-   } else if (timetype==TIME_TICS) {
-      opentimers_vars.timersBuf[id].period_ticks      = newDuration;
-      opentimers_vars.timersBuf[id].wraps_remaining   = (newDuration/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-   } else {
-      // this should never happpen!
-      
-      // we can not print from within the drivers. Instead:
-      // blink the error LED
-      leds_error_blink();
-      // reset the board
-      board_reset();
-   }
-   if(opentimers_vars.timersBuf[id].wraps_remaining==0) {
-      if        (timetype==TIME_MS){
-         opentimers_vars.timersBuf[id].ticks_remaining   = newDuration*PORT_TICS_PER_MS;
-      } else if (timetype==TIME_TICS){
-         opentimers_vars.timersBuf[id].ticks_remaining   = newDuration;
+   opentimers_t* timer;
+   uint32_t      oldPeriod;
+   uint8_t       h;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   timer                = &opentimers_vars.timersBuf[id];
+   oldPeriod            = timer->period_ticks;
+   timer->period_ticks  = opentimers_toTicks(newDuration,timetype);
+
+   if (timer->isrunning==TRUE) {
+      timer->expiry    += timer->period_ticks-oldPeriod;
+      // the expiry moved either way, restore the heap order
+      for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+         opentimers_heapFix(h,timer->heapIdx[h]);
       }
+      opentimers_update();
    } else {
-      opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
+      timer->remaining_ticks = timer->period_ticks;
    }
+   ENABLE_INTERRUPTS();
 }
 
 /**
@@ -167,18 +190,148 @@ Sets the timer to "not running". the system recovers even if this was the next
 timer to expire.
  */
 void opentimers_stop(opentimer_id_t id) {
-   opentimers_vars.timersBuf[id].isrunning=FALSE;
+   opentimers_t* timer;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   timer = &opentimers_vars.timersBuf[id];
+   if (timer->isrunning==TRUE) {
+      // remember how far it was from expiring, for opentimers_restart()
+      timer->remaining_ticks = timer->expiry-opentimers_now();
+      if ((int32_t)timer->remaining_ticks<0) {
+         timer->remaining_ticks = 0;
+      }
+      opentimers_heapRemove(id);
+   }
+   ENABLE_INTERRUPTS();
 }
 
 /**
 \brief Restart a stop timer.
 
-Sets the timer to " running".
+Sets the timer to " running". It expires after the ticks it had left when it
+was stopped; a one-shot timer which already fired expires right away.
  */
 void opentimers_restart(opentimer_id_t id) {
-   opentimers_vars.timersBuf[id].isrunning=TRUE;
+   opentimers_t* timer;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   timer = &opentimers_vars.timersBuf[id];
+   if (timer->isrunning==FALSE) {
+      timer->expiry = opentimers_now()+timer->remaining_ticks;
+      opentimers_heapInsert(id);
+      opentimers_update();
+   }
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Read the virtual clock.
+
+Within a timer callback, this is the time of the hardware timeout being
+handled, not counting interrupt latency.
+
+\returns The current time, in ticks.
+ */
+uint32_t opentimers_getCurrentTime() {
+   uint32_t now;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   now = opentimers_now();
+   ENABLE_INTERRUPTS();
+
+   return now;
+}
+
+/**
+\brief Read the virtual clock, also within timer callbacks.
+
+Unlike opentimers_getCurrentTime(), this keeps advancing while timer callbacks
+are called. Use it to time events, not to start timers.
+
+\returns The number of ticks since opentimers_init(), modulo 2^32.
+ */
+uint32_t opentimers_getUptime() {
+   uint32_t now;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   now = opentimers_counterTime();
+   ENABLE_INTERRUPTS();
+
+   return now;
+}
+
+/**
+\brief Time left before a running timer must fire.
+
+Used to sleep until then with the hardware timer stopped.
+
+\returns The number of ticks until the earliest deadline (expiry plus slack), 0
+   if it already passed, or OPENTIMERS_NO_DEADLINE if no timer is running.
+ */
+uint32_t opentimers_getTimeToNextDeadline() {
+   uint32_t timeLeft;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   if (opentimers_vars.numRunning==0) {
+      timeLeft = OPENTIMERS_NO_DEADLINE;
+   } else {
+      timeLeft = opentimers_heapKey(OPENTIMERS_HEAP_DEADLINE,0)-opentimers_now();
+      if ((int32_t)timeLeft<0) {
+         timeLeft = 0;
+      }
+   }
+   ENABLE_INTERRUPTS();
+
+   return timeLeft;
 }
 
+/**
+\brief Account for time spent asleep with the hardware timer stopped.
+
+Calls the callbacks of the timers which expired while asleep, and restarts the
+hardware timer with the next timer to expire.
+
+\param sleepTime Number of ticks the bsp_timer counter missed.
+ */
+void opentimers_sleepTimeCompensation(uint32_t sleepTime)
+{
+   uint32_t now;
+
+   // the counter stood still, restart it from the compensated time
+   now                            = opentimers_now()+sleepTime;
+   bsp_timer_reset();
+   opentimers_vars.currentTime    = now;
+   opentimers_vars.counterOrigin  = now;
+   opentimers_vars.nextTimeout    = now;
+
+   opentimers_fireExpired();
+   opentimers_scheduleNext();
+}
+
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_opentimers() {
+   opentimers_dbg_t output;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   memcpy(&output,&opentimers_dbg,sizeof(opentimers_dbg_t));
+   ENABLE_INTERRUPTS();
+
+   openserial_printStatus(STATUS_OPENTIMERS,(uint8_t*)&output,sizeof(opentimers_dbg_t));
+   return TRUE;
+}
 
 //=========================== private =========================================
 
@@ -192,167 +345,313 @@ corresponding callback(s), and restarts the hardware timer with the next timer
 to expire.
  */
 void opentimers_timer_callback() {
-   
-   opentimer_id_t   id;
-   PORT_TIMER_WIDTH min_timeout;
-   bool             found;
-    
-   // step 1. Identify expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].isrunning==TRUE) {
-
-         if(opentimers_vars.currentTimeout >= opentimers_vars.timersBuf[id].ticks_remaining) {
-            // this timer has expired
-            //check to see if we have completed the whole timer, or we're just wrapping around the max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining == 0){
-               // declare as so
-               opentimers_vars.timersBuf[id].hasExpired  = TRUE;
-            }else{
-               opentimers_vars.timersBuf[id].wraps_remaining--;
-               if(opentimers_vars.timersBuf[id].wraps_remaining == 0){
-                  //if we have fully wrapped around, then set the remainring ticks to the modulus of the total ticks and the max clock value
-                  opentimers_vars.timersBuf[id].ticks_remaining = (opentimers_vars.timersBuf[id].period_ticks) % MAX_TICKS_IN_SINGLE_CLOCK;
-               }else{
-                  opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-               }
-            }
-         } else {
-            // this timer is not expired
-
-            // update its counter
-            opentimers_vars.timersBuf[id].ticks_remaining -= opentimers_vars.currentTimeout;
-         }   
-      }
+   opentimers_vars.currentTime = opentimers_vars.nextTimeout;
+
+   opentimers_fireExpired();
+   opentimers_scheduleNext();
+}
+
+/**
+\brief Convert a duration into a number of ticks.
+
+Timers of 0 ticks are rounded up to 1 tick, so a periodic timer can not
+expire continuously.
+ */
+uint32_t opentimers_toTicks(uint32_t duration, time_type_t timetype) {
+   uint32_t ticks;
+
+   if        (timetype==TIME_MS) {
+      ticks = duration*PORT_TICS_PER_MS;
+   } else if (timetype==TIME_TICS) {
+      ticks = duration;
+   } else {
+      // this should never happpen!
+
+      // we can not print from within the drivers. Instead:
+      // blink the error LED
+      leds_error_blink();
+      // reset the board
+      board_reset();
+      ticks = 0;
+   }
+   if (ticks==0) {
+      ticks = 1;
    }
+   return ticks;
+}
+
+/**
+\brief Call the callbacks of all timers expired at currentTime.
+
+Periodic timers are reloaded one period after their expiry, before their
+callback is called; one-shot timers are stopped. Callbacks can start, stop or
+restart any timer.
+ */
+void opentimers_fireExpired() {
+   opentimer_id_t id;
+   opentimers_t*  timer;
+   uint8_t        h;
+   uint8_t        numWakeups;
+   uint32_t       lastExpiry;
+
+   opentimers_vars.isFiring = TRUE;
+   opentimers_dbg.numTimeouts++;
+
+   numWakeups = 0;
+   lastExpiry = 0;
+   while (opentimers_vars.numRunning>0) {
+      id    = opentimers_vars.timersHeap[OPENTIMERS_HEAP_EXPIRY][0];
+      timer = &opentimers_vars.timersBuf[id];
+      if ((int32_t)(timer->expiry-opentimers_vars.currentTime)>0) {
+         // earliest timer not expired, neither are the others
+         break;
+      }
 
-   // step 2. call callbacks of expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].hasExpired==TRUE){
-
-         // call the callback
-         opentimers_vars.timersBuf[id].callback();
-         opentimers_vars.timersBuf[id].hasExpired     = FALSE;
-
-         // reload the timer, if applicable
-         if (opentimers_vars.timersBuf[id].type==TIMER_PERIODIC) {
-            opentimers_vars.timersBuf[id].wraps_remaining   = (opentimers_vars.timersBuf[id].period_ticks/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-            //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining==0)                                                
-               opentimers_vars.timersBuf[id].ticks_remaining   = opentimers_vars.timersBuf[id].period_ticks;
-            else
-               opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-
-         } else {
-            opentimers_vars.timersBuf[id].isrunning   = FALSE;
+      // without slack, each distinct expiry would have been a wakeup
+      if (numWakeups==0 || timer->expiry!=lastExpiry) {
+         numWakeups++;
+         lastExpiry = timer->expiry;
+      }
+      opentimers_dbg.numExpirations++;
+
+      // reload the timer, if applicable
+      if (timer->type==TIMER_PERIODIC) {
+         timer->expiry += timer->period_ticks;
+         if ((int32_t)(timer->expiry-opentimers_vars.currentTime)<=0) {
+            // more than one period late (e.g. slept through), skip the missed
+            // periods while keeping the phase
+            timer->expiry += ((opentimers_vars.currentTime-timer->expiry)/
+                              timer->period_ticks+1)*timer->period_ticks;
+         }
+         for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+            opentimers_heapDown(h,timer->heapIdx[h]);
          }
+      } else {
+         opentimers_heapRemove(id);
+         timer->remaining_ticks = 0;
       }
 
+      // call the callback
+      OPENTRACE(OPENTRACE_EVENT_TIMER_FIRED,id);
+      timer->callback();
+   }
+
+   if (numWakeups>1) {
+      opentimers_dbg.numWakeupsSaved += numWakeups-1;
    }
 
-   // step 3. find the minimum remaining timeout among running timers
-   found = FALSE;
-   for(id=0;id<MAX_NUM_TIMERS;id++) {
-      if (
-            opentimers_vars.timersBuf[id].isrunning==TRUE &&
-            (
-                  found==FALSE
-                  ||
-                  opentimers_vars.timersBuf[id].ticks_remaining < min_timeout
-            )
+   opentimers_vars.isFiring = FALSE;
+}
+
+/**
+\brief Schedule the hardware timer for the running timers.
+
+The timeout is set at the earliest deadline (expiry plus slack), where all
+timers expired by then fire together.
+ */
+void opentimers_scheduleNext() {
+   if (opentimers_vars.numRunning==0) {
+      // no more timers pending, only keep the virtual clock running
+      opentimers_scheduleAt(opentimers_vars.currentTime+MAX_TICKS_IN_SINGLE_CLOCK);
+      return;
+   }
+
+   opentimers_scheduleAt(opentimers_heapKey(OPENTIMERS_HEAP_DEADLINE,0));
+}
+
+/**
+\brief Schedule the hardware timer at an absolute time.
+
+Timers further away than MAX_TICKS_IN_SINGLE_CLOCK after currentTime take
+several timeouts, so the counter never wraps between two timeouts.
+
+bsp_timer_scheduleIn() adds its argument to the previous compare value, modulo
+the counter width. Scheduling earlier than an already scheduled timeout hence
+passes a "negative" delay. It however considers any delay shorter than the
+time elapsed since the previous compare value as already passed, which is
+wrong when that value is still to come. A timeout still to come is therefore
+never pushed later: it then fires without expired timer, and target is
+scheduled from its interrupt.
+ */
+void opentimers_scheduleAt(uint32_t target) {
+   if (target-opentimers_vars.currentTime>MAX_TICKS_IN_SINGLE_CLOCK) {
+      target = opentimers_vars.currentTime+MAX_TICKS_IN_SINGLE_CLOCK;
+   }
+
+   if (
+         (int32_t)(target-opentimers_vars.nextTimeout)>0
+         &&
+         (int32_t)(opentimers_vars.nextTimeout-opentimers_now())>0
       ) {
-         min_timeout    = opentimers_vars.timersBuf[id].ticks_remaining;
-         found          = TRUE;
-      }
+      return;
    }
 
-   // step 4. schedule next timeout
-   if (found==TRUE) {
-      // at least one timer pending
-      opentimers_vars.currentTimeout = min_timeout;
-      bsp_timer_scheduleIn(opentimers_vars.currentTimeout);
-   } else {
-      // no more timers pending
-      opentimers_vars.running = FALSE;
+   bsp_timer_scheduleIn((PORT_TIMER_WIDTH)(target-opentimers_vars.nextTimeout));
+   opentimers_vars.nextTimeout = target;
+}
+
+/**
+\brief Re-schedule the hardware timer if a (re)armed timer is due earlier.
+
+Within opentimers_fireExpired(), this is left to opentimers_scheduleNext().
+ */
+void opentimers_update() {
+   uint32_t deadline;
+
+   if (opentimers_vars.isFiring==TRUE) {
+      return;
+   }
+
+   deadline = opentimers_heapKey(OPENTIMERS_HEAP_DEADLINE,0);
+
+   if ((int32_t)(deadline-opentimers_vars.nextTimeout)<0) {
+      opentimers_scheduleAt(deadline);
    }
 }
 
-void opentimers_sleepTimeCompesation(uint16_t sleepTime)
-{
-   opentimer_id_t   id;
-   PORT_TIMER_WIDTH min_timeout;
-   bool             found;
-   
-   //step 1. reCount the ticks_remain after waking up from sleep
-   for(id=0; id<MAX_NUM_TIMERS; id++)
-   {
-     if (opentimers_vars.timersBuf[id].isrunning==TRUE) 
-     {
-       if(opentimers_vars.timersBuf[id].ticks_remaining > sleepTime)
-       {
-         opentimers_vars.timersBuf[id].ticks_remaining -= sleepTime;
-       }
-       else
-       {
-         if(opentimers_vars.timersBuf[id].wraps_remaining > 0)
-         {
-           opentimers_vars.timersBuf[id].wraps_remaining--;
-           opentimers_vars.timersBuf[id].ticks_remaining += (MAX_TICKS_IN_SINGLE_CLOCK - sleepTime);
-         }
-         else
-         {
-           opentimers_vars.timersBuf[id].hasExpired  = TRUE;
-         }
-       }
-     }
+/**
+\brief Read the virtual clock, see opentimers_getCurrentTime().
+
+\pre Interrupts are disabled, or this is the bsp_timer interrupt.
+*/
+uint32_t opentimers_now() {
+   if (opentimers_vars.isFiring==TRUE) {
+      return opentimers_vars.currentTime;
    }
-   
-   // step 2. call callbacks of expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].hasExpired==TRUE){
-
-         // call the callback
-         opentimers_vars.timersBuf[id].callback();
-         opentimers_vars.timersBuf[id].hasExpired     = FALSE;
-
-         // reload the timer, if applicable
-         if (opentimers_vars.timersBuf[id].type==TIMER_PERIODIC) {
-            opentimers_vars.timersBuf[id].wraps_remaining   = (opentimers_vars.timersBuf[id].period_ticks/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-            //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining==0)                                                
-               opentimers_vars.timersBuf[id].ticks_remaining   = opentimers_vars.timersBuf[id].period_ticks;
-            else
-               opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-
-         } else {
-            opentimers_vars.timersBuf[id].isrunning   = FALSE;
-         }
-      }
+   return opentimers_counterTime();
+}
 
+/**
+\brief Read the virtual clock off the bsp_timer counter.
+
+\pre Interrupts are disabled, or this is the bsp_timer interrupt.
+*/
+uint32_t opentimers_counterTime() {
+   PORT_TIMER_WIDTH counterAtCurrentTime;
+
+   // the counter can not have wrapped since currentTime, see scheduleAt()
+   counterAtCurrentTime = (PORT_TIMER_WIDTH)(opentimers_vars.currentTime-
+                                             opentimers_vars.counterOrigin);
+   return opentimers_vars.currentTime+
+          (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-counterAtCurrentTime);
+}
+
+//=== heaps
+
+/**
+\brief Time by which heap h is ordered, for the timer at position i.
+*/
+uint32_t opentimers_heapKey(uint8_t h, uint8_t i) {
+   opentimers_t* timer;
+
+   timer = &opentimers_vars.timersBuf[opentimers_vars.timersHeap[h][i]];
+   if (h==OPENTIMERS_HEAP_DEADLINE) {
+      return timer->expiry+timer->slack_ticks;
    }
-   
-   // step 3. find the minimum remaining timeout among running timers
-   found = FALSE;
-   for(id=0;id<MAX_NUM_TIMERS;id++) {
-      if (
-            opentimers_vars.timersBuf[id].isrunning==TRUE &&
-            (
-                  found==FALSE
-                  ||
-                  opentimers_vars.timersBuf[id].ticks_remaining < min_timeout
-            )
-      ) {
-         min_timeout    = opentimers_vars.timersBuf[id].ticks_remaining;
-         found          = TRUE;
+   return timer->expiry;
+}
+
+/**
+\brief Whether the timer at position i of heap h comes before the one at j.
+*/
+bool opentimers_isEarlier(uint8_t h, uint8_t i, uint8_t j) {
+   return (int32_t)(opentimers_heapKey(h,i)-opentimers_heapKey(h,j))<0;
+}
+
+void opentimers_heapSwap(uint8_t h, uint8_t i, uint8_t j) {
+   opentimer_id_t id;
+
+   id                                = opentimers_vars.timersHeap[h][i];
+   opentimers_vars.timersHeap[h][i]  = opentimers_vars.timersHeap[h][j];
+   opentimers_vars.timersHeap[h][j]  = id;
+   opentimers_vars.timersBuf[opentimers_vars.timersHeap[h][i]].heapIdx[h] = i;
+   opentimers_vars.timersBuf[opentimers_vars.timersHeap[h][j]].heapIdx[h] = j;
+}
+
+/**
+\brief Move the timer at position i of heap h up, while it comes before its
+   parent.
+*/
+void opentimers_heapUp(uint8_t h, uint8_t i) {
+   uint8_t parent;
+
+   while (i>0) {
+      parent = (i-1)/2;
+      if (opentimers_isEarlier(h,i,parent)==FALSE) {
+         break;
       }
+      opentimers_heapSwap(h,i,parent);
+      i = parent;
    }
+}
 
-   // step 4. schedule next timeout
-   if (found==TRUE) {
-      // at least one timer pending
-      opentimers_vars.currentTimeout = min_timeout;
-      bsp_timer_scheduleIn(opentimers_vars.currentTimeout);
+/**
+\brief Move the timer at position i of heap h down, while a child comes before
+   it.
+*/
+void opentimers_heapDown(uint8_t h, uint8_t i) {
+   uint8_t child;
+   uint8_t earliest;
+
+   while (1) {
+      earliest = i;
+      child    = 2*i+1;
+      if (child<opentimers_vars.numRunning && opentimers_isEarlier(h,child,earliest)) {
+         earliest = child;
+      }
+      child++;
+      if (child<opentimers_vars.numRunning && opentimers_isEarlier(h,child,earliest)) {
+         earliest = child;
+      }
+      if (earliest==i) {
+         break;
+      }
+      opentimers_heapSwap(h,i,earliest);
+      i = earliest;
+   }
+}
+
+/**
+\brief Restore the order of heap h after the key at position i changed.
+*/
+void opentimers_heapFix(uint8_t h, uint8_t i) {
+   if (i>0 && opentimers_isEarlier(h,i,(i-1)/2)) {
+      opentimers_heapUp(h,i);
    } else {
-      // no more timers pending
-      opentimers_vars.running = FALSE;
+      opentimers_heapDown(h,i);
+   }
+}
+
+/**
+\brief Add an unused timer to the heaps of running timers.
+*/
+void opentimers_heapInsert(opentimer_id_t id) {
+   uint8_t h;
+
+   for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+      opentimers_heapSwap(h,opentimers_vars.timersBuf[id].heapIdx[h],opentimers_vars.numRunning);
+   }
+   opentimers_vars.numRunning++;
+   opentimers_vars.timersBuf[id].isrunning = TRUE;
+   for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+      opentimers_heapUp(h,opentimers_vars.numRunning-1);
+   }
+}
+
+/**
+\brief Remove a running timer from the heaps, replacing it by the last one.
+*/
+void opentimers_heapRemove(opentimer_id_t id) {
+   uint8_t h;
+   uint8_t i;
+
+   opentimers_vars.numRunning--;
+   opentimers_vars.timersBuf[id].isrunning = FALSE;
+   for (h=0;h<OPENTIMERS_NUM_HEAPS;h++) {
+      i = opentimers_vars.timersBuf[id].heapIdx[h];
+      opentimers_heapSwap(h,i,opentimers_vars.numRunning);
+      if (i<opentimers_vars.numRunning) {
+         opentimers_heapFix(h,i);
+      }
    }
 }
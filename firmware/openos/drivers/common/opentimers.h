@@ -12,14 +12,24 @@
 //=========================== define ==========================================
 
 /// Maximum number of timers that can run concurrently
+#ifndef MAX_NUM_TIMERS
 #define MAX_NUM_TIMERS            10
+#endif
 
 #define MAX_TICKS_IN_SINGLE_CLOCK ((PORT_TIMER_WIDTH)0xFFFFFFFF)
 
 #define TOO_MANY_TIMERS_ERROR     255
 
+/// returned by opentimers_getTimeToNextDeadline() when no timer is running
+#define OPENTIMERS_NO_DEADLINE    0xFFFFFFFF
+
 #define opentimer_id_t uint8_t
 
+// running timers are kept in two heaps, see opentimers_vars_t
+#define OPENTIMERS_HEAP_EXPIRY    0         // ordered by expiry
+#define OPENTIMERS_HEAP_DEADLINE  1         // ordered by expiry plus slack
+#define OPENTIMERS_NUM_HEAPS      2
+
 typedef void (*opentimers_cbt)();
 
 //=========================== typedef =========================================
@@ -37,23 +47,58 @@ typedef enum {
 
 typedef struct {
    uint32_t             period_ticks;       // total number of clock ticks
-   PORT_TIMER_WIDTH     ticks_remaining;    // ticks remaining before elapses
-   uint16_t             wraps_remaining;    // the clock register is 16 bit, and can't count beyond 32k...
-                                            // so period_ticks = wraps_remaining*(32k or uint16_t)
+   uint32_t             slack_ticks;        // how late it may fire
+   uint32_t             expiry;             // time at which it elapses, in ticks
+   uint32_t             remaining_ticks;    // ticks left when stopped, for opentimers_restart()
    timer_type_t         type;               // periodic or one-shot
    bool                 isrunning;          // is running?
    opentimers_cbt       callback;           // function to call when elapses
-   bool                 hasExpired;         // whether the callback has to be called
+   uint8_t              heapIdx[OPENTIMERS_NUM_HEAPS]; // position in timersHeap
 } opentimers_t;
 
 //=========================== module variables ================================
 
+/**
+\brief Timer driver state.
+
+Each row of timersHeap holds every timer id exactly once. Its first numRunning
+entries are the running timers, organized as a binary min-heap; the remaining
+entries are the unused timers. The OPENTIMERS_HEAP_EXPIRY heap is ordered by
+expiry, the OPENTIMERS_HEAP_DEADLINE heap by expiry plus slack. Starting or
+stopping a timer hence takes O(log MAX_NUM_TIMERS) operations. The hardware
+timer is set for the earliest deadline, and then fires every timer expired at
+that time, earliest first.
+
+Expiry times are absolute, on a 32-bit virtual clock extending the bsp_timer
+counter. Since bsp_timer_scheduleIn() is relative to the previous compare
+value, nextTimeout tracks that value, and the hardware timer is always
+scheduled for an absolute time. Periodic timers are reloaded at their previous
+expiry plus their period, so interrupt latency does not accumulate.
+
+The hardware timer is always scheduled, MAX_TICKS_IN_SINGLE_CLOCK ticks ahead
+at most, even while no timer is running; the counter hence never wraps
+unnoticed, and the virtual clock keeps running from opentimers_init() on.
+Times are compared modulo 2^32, so a timer can not be longer than 2^31 ticks.
+
+\note MAX_NUM_TIMERS must be lower than TOO_MANY_TIMERS_ERROR.
+*/
 typedef struct {
    opentimers_t         timersBuf[MAX_NUM_TIMERS];
-   bool                 running;
-   PORT_TIMER_WIDTH     currentTimeout; // current timeout, in ticks
+   opentimer_id_t       timersHeap[OPENTIMERS_NUM_HEAPS][MAX_NUM_TIMERS];
+   uint8_t              numRunning;         // number of running timers
+   bool                 isFiring;           // are we calling timer callbacks?
+   uint32_t             currentTime;        // time of the last timeout handled
+   uint32_t             counterOrigin;      // time at which the counter read 0
+   uint32_t             nextTimeout;        // time the hardware timer is set for
 } opentimers_vars_t;
 
+typedef struct {
+   uint16_t             numTimeouts;        // hardware timeouts handled
+   uint16_t             numExpirations;     // timer callbacks called
+   // timeouts avoided by firing timers of different expiry together
+   uint16_t             numWakeupsSaved;
+} opentimers_dbg_t;
+
 //=========================== prototypes ======================================
 
 void           opentimers_init();
@@ -61,10 +106,19 @@ opentimer_id_t opentimers_start(uint32_t       duration,
                                 timer_type_t   type,
                                 time_type_t timetype,
                                 opentimers_cbt callback);
+opentimer_id_t opentimers_start_with_slack(uint32_t       duration,
+                                           uint32_t       slack,
+                                           timer_type_t   type,
+                                           time_type_t    timetype,
+                                           opentimers_cbt callback);
 void           opentimers_setPeriod(opentimer_id_t id,time_type_t timetype, uint32_t       newPeriod);
 void           opentimers_stop(opentimer_id_t id);
 void           opentimers_restart(opentimer_id_t id);
+uint32_t       opentimers_getCurrentTime();
+uint32_t       opentimers_getUptime();
+uint32_t       opentimers_getTimeToNextDeadline();
 
-void           opentimers_sleepTimeCompesation(uint16_t sleepTime);
+void           opentimers_sleepTimeCompensation(uint32_t sleepTime);
+bool           debugPrint_opentimers();
 
 #endif
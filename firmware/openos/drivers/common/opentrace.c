@@ -0,0 +1,155 @@
+/**
+\brief Definition of the "opentrace" driver.
+
+Trace points record 4-byte events, timestamped with the radiotimer, in a RAM
+ring. opentrace_flush() prints the records in the ring as a single trace frame,
+which projects/python/opentrace_decode.py decodes on the PC.
+
+Only compiled in with OPENTRACE_ENABLED, so projects without it need not list
+this file.
+*/
+
+#include "openwsn.h"
+#include "opentrace.h"
+#include "openserial.h"
+#include "radiotimer.h"
+
+#ifdef OPENTRACE_ENABLED
+
+//=========================== variables =======================================
+
+opentrace_vars_t opentrace_vars;
+opentrace_dbg_t  opentrace_dbg;
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void opentrace_init() {
+   memset(&opentrace_vars,0,sizeof(opentrace_vars_t));
+   memset(&opentrace_dbg,0,sizeof(opentrace_dbg_t));
+}
+
+/**
+\brief Record a trace event.
+
+Use the OPENTRACE() macro rather than this function, so trace points are
+compiled out of builds without OPENTRACE_ENABLED.
+
+\param[in] event Which event, one of OPENTRACE_EVENT_*.
+\param[in] arg   An argument of the event.
+*/
+void opentrace_record(uint8_t event, uint8_t arg) {
+   uint16_t timestamp;
+   uint8_t* record;
+   INTERRUPT_DECLARATION();
+   
+   timestamp = (uint16_t)radiotimer_getValue();
+   
+   DISABLE_INTERRUPTS();
+   if ((uint8_t)(opentrace_vars.idxW-opentrace_vars.idxR)>=OPENTRACE_NUM_RECORDS) {
+      // ring full, the flush records how many were dropped
+      opentrace_vars.numDropped++;
+      opentrace_dbg.numDropped++;
+   } else {
+      record    = &opentrace_vars.ring[(opentrace_vars.idxW&OPENTRACE_NUM_RECORDS_MASK)*OPENTRACE_RECORD_LEN];
+      record[0] = event;
+      record[1] = (timestamp>>0)&0xff;
+      record[2] = (timestamp>>8)&0xff;
+      record[3] = arg;
+      opentrace_vars.idxW++;
+      opentrace_dbg.numRecords++;
+   }
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Print the records in the ring, as a single trace frame.
+
+A frame holds at most OPENTRACE_MAX_FLUSH records, the oldest ones; the others
+wait for the next flush. Records are dropped when the ring is full, so they are
+newer than all the records in it: once the ring is emptied, the frame ends with
+an OPENTRACE_EVENT_DROPPED record saying how many. Records are only removed
+from the ring once the frame is printed.
+*/
+void opentrace_flush() {
+   uint8_t  buf[OPENTRACE_MAX_FLUSH*OPENTRACE_RECORD_LEN];
+   uint8_t  numRecords;
+   uint8_t  numCopied;
+   uint8_t  idxR;
+   uint16_t numDropped;
+   uint16_t timestamp;
+   uint8_t  len;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   idxR       = opentrace_vars.idxR;
+   numRecords = opentrace_vars.idxW-idxR;
+   numDropped = opentrace_vars.numDropped;
+   ENABLE_INTERRUPTS();
+   
+   if (numRecords==0 && numDropped==0) {
+      return;
+   }
+   
+   // the records between idxR and idxW are not written to
+   len       = 0;
+   numCopied = 0;
+   while (numCopied<numRecords && len<sizeof(buf)) {
+      memcpy(
+         &buf[len],
+         &opentrace_vars.ring[((idxR+numCopied)&OPENTRACE_NUM_RECORDS_MASK)*OPENTRACE_RECORD_LEN],
+         OPENTRACE_RECORD_LEN
+      );
+      len       += OPENTRACE_RECORD_LEN;
+      numCopied++;
+   }
+   
+   if (numDropped>0) {
+      if (numCopied<numRecords || len==sizeof(buf)) {
+         // the drops come after the records left in the ring
+         numDropped = 0;
+      } else {
+         timestamp  = (uint16_t)radiotimer_getValue();
+         buf[len++] = OPENTRACE_EVENT_DROPPED;
+         buf[len++] = (timestamp>>0)&0xff;
+         buf[len++] = (timestamp>>8)&0xff;
+         buf[len++] = (numDropped>0xff) ? 0xff : (uint8_t)numDropped;
+      }
+   }
+   
+   if (openserial_printTrace(buf,len)!=E_SUCCESS) {
+      // try again at the next flush
+      return;
+   }
+   
+   DISABLE_INTERRUPTS();
+   opentrace_vars.idxR        = idxR+numCopied;
+   opentrace_vars.numDropped -= numDropped;
+   ENABLE_INTERRUPTS();
+   opentrace_dbg.numFrames++;
+}
+
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_opentrace() {
+   opentrace_dbg_t output;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   memcpy(&output,&opentrace_dbg,sizeof(opentrace_dbg_t));
+   ENABLE_INTERRUPTS();
+   
+   openserial_printStatus(STATUS_OPENTRACE,(uint8_t*)&output,sizeof(opentrace_dbg_t));
+   return TRUE;
+}
+
+//=========================== private =========================================
+
+#endif
@@ -0,0 +1,97 @@
+/**
+\brief Declaration of the "opentrace" driver.
+*/
+
+#ifndef __OPENTRACE_H
+#define __OPENTRACE_H
+
+#include "openwsn.h"
+
+/**
+\addtogroup cross-layers
+\{
+\addtogroup OpenTrace
+\{
+*/
+
+//=========================== define ==========================================
+
+/// Number of bytes of a trace record: event (1B), timestamp (2B), argument (1B).
+#define OPENTRACE_RECORD_LEN      4
+
+/**
+\brief Number of trace records the ring holds.
+
+\warning Must be a power of two, not greater than 128.
+*/
+#ifndef OPENTRACE_NUM_RECORDS
+#define OPENTRACE_NUM_RECORDS     64
+#endif
+
+#if (OPENTRACE_NUM_RECORDS&(OPENTRACE_NUM_RECORDS-1))!=0 || OPENTRACE_NUM_RECORDS>128
+#error OPENTRACE_NUM_RECORDS must be a power of two, not greater than 128
+#endif
+
+#define OPENTRACE_NUM_RECORDS_MASK (OPENTRACE_NUM_RECORDS-1)
+
+/// Maximum number of trace records in a trace frame.
+#define OPENTRACE_MAX_FLUSH       32
+
+/// Trace events of the drivers and kernel; the stack numbers its own from OPENTRACE_EVENT_STACK.
+enum {
+   OPENTRACE_EVENT_DROPPED        = 0x00, ///< records dropped, ring full; argument: how many, at most 255
+   OPENTRACE_EVENT_TIMER_FIRED    = 0x01, ///< an opentimers timer fired; argument: its id
+   OPENTRACE_EVENT_TASK_RUN       = 0x02, ///< the scheduler runs a task; argument: low byte of its callback address
+   OPENTRACE_EVENT_STACK          = 0x10, ///< first event free for the stack
+};
+
+/**
+\brief Record a trace event, if OPENTRACE_ENABLED is defined.
+
+Trace points cost nothing in builds without OPENTRACE_ENABLED; the ring, the
+trace frames and the STATUS_OPENTRACE status element are then compiled out too.
+*/
+#ifdef OPENTRACE_ENABLED
+#define OPENTRACE(event,arg)      opentrace_record((event),(arg))
+#else
+#define OPENTRACE(event,arg)
+#endif
+
+//=========================== typedef =========================================
+
+//=========================== module variables ================================
+
+/**
+\brief Opentrace state.
+
+The ring holds OPENTRACE_NUM_RECORDS records of OPENTRACE_RECORD_LEN bytes,
+each written whole with interrupts disabled, so trace points can be in
+interrupt handlers. idxW and idxR run freely; their difference is the number
+of records in the ring.
+*/
+typedef struct {
+   uint8_t              idxW;               // next record written
+   uint8_t              idxR;               // next record flushed
+   uint16_t             numDropped;         // records dropped since the last flush
+   uint8_t              ring[OPENTRACE_NUM_RECORDS*OPENTRACE_RECORD_LEN];
+} opentrace_vars_t;
+
+typedef struct {
+   uint16_t             numRecords;         // records written to the ring
+   uint16_t             numDropped;         // records dropped, ring full
+   uint16_t             numFrames;          // trace frames printed
+} opentrace_dbg_t;
+
+//=========================== prototypes ======================================
+
+void      opentrace_init();
+void      opentrace_record(uint8_t event, uint8_t arg);
+void      opentrace_flush();
+bool      debugPrint_opentrace();
+
+/**
+\}
+\}
+*/
+
+#endif
@@ -7,99 +7,641 @@
 #include "openwsn.h"
 #include "scheduler.h"
 #include "board.h"
+#include "bsp_timer.h"
 #include "debugpins.h"
 #include "leds.h"
+#include "opentimers.h"
+#include "opentrace.h"
 
 //=========================== variables =======================================
 
 scheduler_vars_t scheduler_vars;
 scheduler_dbg_t  scheduler_dbg;
 
+/// index of the least significant bit set in a 4-bit value (0 maps to 4)
+static const uint8_t scheduler_lsbTable[16] = {
+   4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
 //=========================== prototypes ======================================
 
-void consumeTask(uint8_t taskId);
+task_cbt         scheduler_popTask();
+#ifdef SCHEDULER_EDF
+task_cbt         scheduler_popDeadlineTask(uint32_t now);
+#endif
+void             scheduler_freeContainer(taskList_item_t* taskContainer);
+owerror_t        scheduler_push_task_locked(task_cbt cb, task_prio_t prio, bool* overflown);
+taskList_item_t* scheduler_takeContainer();
+taskList_item_t* scheduler_dequeue(uint8_t prio);
+taskList_item_t* scheduler_findTask(task_cbt cb, task_prio_t prio);
+taskList_item_t* scheduler_reclaim(task_prio_t prio);
+void             scheduler_notifyOverflow(task_cbt cb, task_prio_t prio, owerror_t outcome);
+void             scheduler_sleep();
+#ifdef SCHEDULER_PROFILING
+void             scheduler_profileTask(task_cbt cb, PORT_TIMER_WIDTH duration);
+#endif
 
 //=========================== public ==========================================
 
-void scheduler_init() {   
-   
+void scheduler_init() {
+   uint8_t i;
+
    // initialization module variables
    memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
    memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
-   
+
+   // chain all task containers into the free list
+   for (i=0;i<TASK_LIST_DEPTH-1;i++) {
+      scheduler_vars.taskBuf[i].next = &scheduler_vars.taskBuf[i+1];
+   }
+   scheduler_vars.taskBuf[TASK_LIST_DEPTH-1].next = NULL;
+   scheduler_vars.freeList        = &scheduler_vars.taskBuf[0];
+
    // enable the scheduler's interrupt so SW can wake up the scheduler
    SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start() {
-   taskList_item_t* pThisTask;
+   task_cbt         cb;
+#ifdef SCHEDULER_EDF
+   uint32_t         now;
+#endif
+#ifdef SCHEDULER_PROFILING
+   PORT_TIMER_WIDTH startTime;
+#endif
+   INTERRUPT_DECLARATION();
+
    while (1) {
-      while(scheduler_vars.task_list!=NULL) {
-         // there is still at least one task in the linked-list of tasks
-         
-         // the task to execute is the one at the head of the queue
-         pThisTask                = scheduler_vars.task_list;
-         
-         // shift the queue by one task
-         scheduler_vars.task_list = pThisTask->next;
-         
+#ifdef SCHEDULER_EDF
+      while(scheduler_vars.readyBitmap!=0 || scheduler_vars.deadlineList!=NULL) {
+#else
+      while(scheduler_vars.readyBitmap!=0) {
+#endif
+         // there is still at least one task pending
+
+         // retrieve the next task to execute, freeing its container
+#ifdef SCHEDULER_EDF
+         // read the clock before, critical sections must not nest
+         now = SCHEDULER_DEADLINE_NOW();
+         DISABLE_INTERRUPTS();
+         if (scheduler_vars.deadlineList!=NULL) {
+            cb = scheduler_popDeadlineTask(now);
+         } else {
+            cb = scheduler_popTask();
+         }
+         ENABLE_INTERRUPTS();
+#else
+         DISABLE_INTERRUPTS();
+         cb = scheduler_popTask();
+         ENABLE_INTERRUPTS();
+#endif
+
          // execute the current task
-         pThisTask->cb();
-         
-         // free up this task container
-         pThisTask->cb            = NULL;
-         pThisTask->prio          = TASKPRIO_NONE;
-         pThisTask->next          = NULL;
-         scheduler_dbg.numTasksCur--;
+         OPENTRACE(OPENTRACE_EVENT_TASK_RUN,(uint8_t)(uintptr_t)cb);
+#ifdef SCHEDULER_PROFILING
+         startTime = SCHEDULER_PROFILE_NOW();
+         cb();
+         scheduler_profileTask(cb,(PORT_TIMER_WIDTH)(SCHEDULER_PROFILE_NOW()-startTime));
+#else
+         cb();
+#endif
       }
       debugpins_task_clr();
-      board_sleep();
+      scheduler_sleep();
       debugpins_task_set();                      // IAR should halt here if nothing to do
    }
 }
 
- void scheduler_push_task(task_cbt cb, task_prio_t prio) {
-   taskList_item_t*  taskContainer;
-   taskList_item_t** taskListWalker;
+/**
+\brief Schedule a task for execution.
+
+Can be called from interrupt mode.
+
+\param cb   The function to execute.
+\param prio The priority of the task.
+
+\returns E_SUCCESS if the task will be executed.
+\returns E_FAIL if the task list is full and SCHEDULER_OVERFLOW_POLICY
+         rejected this task.
+*/
+owerror_t scheduler_push_task(task_cbt cb, task_prio_t prio) {
+   owerror_t outcome;
+   bool      overflown;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   outcome = scheduler_push_task_locked(cb,prio,&overflown);
+   ENABLE_INTERRUPTS();
+
+   if (overflown==TRUE) {
+      scheduler_notifyOverflow(cb,prio,outcome);
+   }
+
+   return outcome;
+}
+
+/**
+\brief Schedule a task for execution, unless it is already pending.
+
+If the same callback is already pending at the same priority, this push is
+folded into it: the callback executes once, and numCoalesceHits is incremented.
+Use this for events which may fire several times before the scheduler runs,
+when one execution handles them all.
+
+Can be called from interrupt mode.
+
+\param cb   The function to execute.
+\param prio The priority of the task.
+
+\returns E_SUCCESS if the task is pending.
+\returns E_FAIL if the task list is full and SCHEDULER_OVERFLOW_POLICY
+         rejected this task.
+*/
+owerror_t scheduler_push_task_coalesce(task_cbt cb, task_prio_t prio) {
+   owerror_t outcome;
+   bool      overflown;
    INTERRUPT_DECLARATION();
    
+   // look up and push in the same critical section, or an interrupt could
+   // push the same task in between
    DISABLE_INTERRUPTS();
+   if (scheduler_findTask(cb,prio)!=NULL) {
+      scheduler_dbg.numCoalesceHits++;
+      overflown = FALSE;
+      outcome   = E_SUCCESS;
+   } else {
+      outcome   = scheduler_push_task_locked(cb,prio,&overflown);
+   }
+   ENABLE_INTERRUPTS();
    
-   // find an empty task container
-   taskContainer = &scheduler_vars.taskBuf[0];
-   while (taskContainer->cb!=NULL &&
-          taskContainer<=&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      taskContainer++;
+   if (overflown==TRUE) {
+      scheduler_notifyOverflow(cb,prio,outcome);
    }
-   if (taskContainer>&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      // task list has overflown. This should never happpen!
    
-      // we can not print from within the kernel. Instead:
-      // blink the error LED
-      leds_error_blink();
-      // reset the board
-      board_reset();
+   return outcome;
+}
+
+#ifdef SCHEDULER_EDF
+/**
+\brief Schedule a task which has to execute before a deadline.
+
+Tasks pushed with a deadline execute before all the tasks pushed with
+scheduler_push_task(), whatever their priority: earliest deadline first, the
+priority only breaking ties, then in the order they were pushed. A task which
+starts executing after its deadline is counted in
+scheduler_dbg.numDeadlineMisses. SCHEDULER_OVERFLOW_DROPLOWEST never drops
+them.
+
+Can be called from interrupt mode.
+
+\param cb             The function to execute.
+\param prio           The priority of the task.
+\param deadline_ticks Number of SCHEDULER_DEADLINE_NOW() ticks from now by
+                      which the task should have started executing.
+
+\returns E_SUCCESS if the task will be executed.
+\returns E_FAIL if the task list is full and SCHEDULER_OVERFLOW_POLICY
+         rejected this task.
+*/
+owerror_t scheduler_push_task_deadline(task_cbt cb, task_prio_t prio, uint32_t deadline_ticks) {
+   taskList_item_t*  taskContainer;
+   taskList_item_t*  prev;
+   taskList_item_t*  walker;
+   uint32_t          deadline;
+   bool              overflown;
+   INTERRUPT_DECLARATION();
+   
+   // read the clock before, critical sections must not nest
+   deadline = SCHEDULER_DEADLINE_NOW()+deadline_ticks;
+   
+   DISABLE_INTERRUPTS();
+   
+   // take an empty task container from the free list
+   overflown     = FALSE;
+   taskContainer = scheduler_takeContainer();
+   if (taskContainer==NULL) {
+      // task list has overflown, apply SCHEDULER_OVERFLOW_POLICY
+      scheduler_dbg.numOverflows++;
+      overflown = TRUE;
+      taskContainer = scheduler_reclaim(prio);
+      if (taskContainer==NULL) {
+         scheduler_dbg.numRejected++;
+         ENABLE_INTERRUPTS();
+         scheduler_notifyOverflow(cb,prio,E_FAIL);
+         return E_FAIL;
+      }
    }
+   
    // fill that task container with this task
    taskContainer->cb              = cb;
    taskContainer->prio            = prio;
+   taskContainer->deadline        = deadline;
    
-   // find position in queue
-   taskListWalker                 = &scheduler_vars.task_list;
-   while (*taskListWalker!=NULL &&
-          (*taskListWalker)->prio < taskContainer->prio) {
-      taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
+   // insert after the deadline tasks due earlier, or due at the same time with
+   // the same or a higher priority
+   prev                           = NULL;
+   walker                         = scheduler_vars.deadlineList;
+   while (
+         walker!=NULL &&
+         (
+            (int32_t)(walker->deadline-deadline)<0 ||
+            (walker->deadline==deadline && walker->prio<=prio)
+         )
+      ) {
+      prev                        = walker;
+      walker                      = walker->next;
    }
-   // insert at that position
-   taskContainer->next            = *taskListWalker;
-   *taskListWalker                = taskContainer;
-   // maintain debug stats
-   scheduler_dbg.numTasksCur++;
-   if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
-      scheduler_dbg.numTasksMax   = scheduler_dbg.numTasksCur;
+   taskContainer->next            = walker;
+   if (prev==NULL) {
+      scheduler_vars.deadlineList = taskContainer;
+   } else {
+      prev->next                  = taskContainer;
    }
    
    ENABLE_INTERRUPTS();
+   
+   if (overflown==TRUE) {
+      scheduler_notifyOverflow(cb,prio,E_SUCCESS);
+   }
+   
+   return E_SUCCESS;
+}
+#endif
+
+/**
+\brief Register the function to call after each task list overflow.
+
+The kernel can not print, so this is how the overflows get reported. The
+callback executes with interrupts enabled, in the context of the push which
+overflowed, possibly interrupt mode. SCHEDULER_OVERFLOW_RESET resets the board
+without calling it.
+
+\param cb The function to call, NULL for none.
+*/
+void scheduler_setOverflowCb(scheduler_overflow_cbt cb) {
+   scheduler_vars.overflow_cb     = cb;
+}
+
+/**
+\brief Copy the scheduler statistics, consistently.
+
+\param[out] dbg Where to copy them.
+*/
+void scheduler_getDbg(scheduler_dbg_t* dbg) {
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+   memcpy(dbg,&scheduler_dbg,sizeof(scheduler_dbg_t));
+   ENABLE_INTERRUPTS();
+}
+
+#ifdef SCHEDULER_PROFILING
+/**
+\brief Get the execution time statistics of one callback.
+
+Successive calls walk through the profiling table, one entry per call, so each
+status frame stays short. Call it in task context only.
+
+\param[out] output Where to write the statistics.
+
+\returns TRUE if output was written, FALSE if nothing was profiled yet.
+*/
+bool scheduler_getProfile(scheduler_profile_dbg_t* output) {
+   scheduler_profile_t*    entry;
+   uint8_t                 i;
+   
+   // find the next used entry
+   for (i=0;i<SCHEDULER_PROFILE_DEPTH;i++) {
+      entry = &scheduler_vars.profile[scheduler_vars.profilePrintIdx];
+      output->index = scheduler_vars.profilePrintIdx;
+      scheduler_vars.profilePrintIdx = (scheduler_vars.profilePrintIdx+1)%SCHEDULER_PROFILE_DEPTH;
+      if (entry->cb!=NULL) {
+         break;
+      }
+   }
+   if (entry->cb==NULL) {
+      // nothing profiled yet
+      return FALSE;
+   }
+   
+   output->cb            = (uint32_t)(uintptr_t)entry->cb;
+   output->count         = entry->count;
+   output->minDuration   = entry->minDuration;
+   output->maxDuration   = entry->maxDuration;
+   output->totalDuration = entry->totalDuration;
+   
+   return TRUE;
 }
+#endif
 
 //=========================== private =========================================
+
+/**
+\brief Remove the highest priority pending task.
+
+The lowest task_prio_t value is the highest priority; it is the index of the
+least significant bit set in readyBitmap.
+
+\pre Interrupts are disabled and readyBitmap is not 0.
+
+\returns The callback of the task, whose container is back in the free list.
+*/
+task_cbt scheduler_popTask() {
+   taskList_item_t*  taskContainer;
+   uint8_t           prio;
+   task_cbt          cb;
+
+   // find the highest priority non-empty FIFO
+   if (scheduler_vars.readyBitmap & 0x0f) {
+      prio = scheduler_lsbTable[scheduler_vars.readyBitmap & 0x0f];
+   } else {
+      prio = 4+scheduler_lsbTable[scheduler_vars.readyBitmap >> 4];
+   }
+
+   // dequeue its head
+   taskContainer                  = scheduler_dequeue(prio);
+   cb                             = taskContainer->cb;
+
+   scheduler_freeContainer(taskContainer);
+
+   return cb;
+}
+
+#ifdef SCHEDULER_EDF
+/**
+\brief Remove the pending task with the earliest deadline.
+
+\pre Interrupts are disabled and deadlineList is not empty.
+
+\param now The SCHEDULER_DEADLINE_NOW() time, to tell whether the task is late.
+
+\returns The callback of the task, whose container is back in the free list.
+*/
+task_cbt scheduler_popDeadlineTask(uint32_t now) {
+   taskList_item_t*  taskContainer;
+   task_cbt          cb;
+
+   taskContainer                  = scheduler_vars.deadlineList;
+   scheduler_vars.deadlineList    = taskContainer->next;
+   cb                             = taskContainer->cb;
+
+   // is this task late?
+   if ((int32_t)(now-taskContainer->deadline)>0) {
+      scheduler_dbg.numDeadlineMisses++;
+   }
+
+   scheduler_freeContainer(taskContainer);
+
+   return cb;
+}
+#endif
+
+/**
+\brief Put back a task container in the free list.
+
+\pre Interrupts are disabled, and the container is neither in a FIFO nor in
+   the free list.
+*/
+void scheduler_freeContainer(taskList_item_t* taskContainer) {
+   taskContainer->cb              = NULL;
+   taskContainer->prio            = TASKPRIO_NONE;
+   taskContainer->next            = scheduler_vars.freeList;
+   scheduler_vars.freeList        = taskContainer;
+   scheduler_dbg.numTasksCur--;
+}
+
+/**
+\brief Append a task to the FIFO of its priority.
+
+Interrupts are not touched: on some boards ENABLE_INTERRUPTS() does not restore
+the state DISABLE_INTERRUPTS() saved, so critical sections must not nest.
+
+\pre Interrupts are disabled.
+
+\param cb        The function to execute.
+\param prio      The priority of the task.
+\param overflown Set to TRUE if the task list was full, FALSE otherwise.
+
+\returns E_SUCCESS if the task will be executed, E_FAIL if it was rejected.
+*/
+owerror_t scheduler_push_task_locked(task_cbt cb, task_prio_t prio, bool* overflown) {
+   taskList_item_t*  taskContainer;
+   taskFifo_t*       fifo;
+   
+   // take an empty task container from the free list
+   *overflown    = FALSE;
+   taskContainer = scheduler_takeContainer();
+   if (taskContainer==NULL) {
+      // task list has overflown, apply SCHEDULER_OVERFLOW_POLICY
+      scheduler_dbg.numOverflows++;
+      *overflown = TRUE;
+#if SCHEDULER_OVERFLOW_POLICY==SCHEDULER_OVERFLOW_COALESCE
+      // the same callback pending at the same priority will do the job
+      if (scheduler_findTask(cb,prio)!=NULL) {
+         scheduler_dbg.numCoalesced++;
+         return E_SUCCESS;
+      }
+#endif
+      taskContainer = scheduler_reclaim(prio);
+      if (taskContainer==NULL) {
+         scheduler_dbg.numRejected++;
+         return E_FAIL;
+      }
+   }
+   
+   // fill that task container with this task
+   taskContainer->cb              = cb;
+   taskContainer->prio            = prio;
+   taskContainer->next            = NULL;
+   
+   // append to the FIFO of that priority
+   fifo                           = &scheduler_vars.fifo[prio];
+   if (fifo->tail==NULL) {
+      fifo->head                  = taskContainer;
+   } else {
+      fifo->tail->next            = taskContainer;
+   }
+   fifo->tail                     = taskContainer;
+   scheduler_vars.readyBitmap    |= (1<<prio);
+   
+   return E_SUCCESS;
+}
+
+/**
+\brief Take a container from the free list.
+
+\pre Interrupts are disabled.
+
+\returns The container, or NULL if none is free.
+*/
+taskList_item_t* scheduler_takeContainer() {
+   taskList_item_t*  taskContainer;
+   
+   taskContainer = scheduler_vars.freeList;
+   if (taskContainer!=NULL) {
+      scheduler_vars.freeList     = taskContainer->next;
+      
+      // maintain debug stats
+      scheduler_dbg.numTasksCur++;
+      if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
+         scheduler_dbg.numTasksMax = scheduler_dbg.numTasksCur;
+      }
+   }
+   
+   return taskContainer;
+}
+
+/**
+\brief Unlink the oldest task of a non-empty FIFO.
+
+\pre Interrupts are disabled and fifo[prio] is not empty.
+
+\returns The task container, which is neither in a FIFO nor in the free list.
+*/
+taskList_item_t* scheduler_dequeue(uint8_t prio) {
+   taskList_item_t*  taskContainer;
+   taskFifo_t*       fifo;
+
+   fifo                           = &scheduler_vars.fifo[prio];
+   taskContainer                  = fifo->head;
+   fifo->head                     = taskContainer->next;
+   if (fifo->head==NULL) {
+      fifo->tail                  = NULL;
+      scheduler_vars.readyBitmap &= ~(1<<prio);
+   }
+
+   return taskContainer;
+}
+
+/**
+\brief Find a pending task.
+
+\pre Interrupts are disabled.
+
+\returns The container of the oldest task with that callback and priority, or
+         NULL if there is none.
+*/
+taskList_item_t* scheduler_findTask(task_cbt cb, task_prio_t prio) {
+   taskList_item_t*  taskContainer;
+   
+   taskContainer = scheduler_vars.fifo[prio].head;
+   while (taskContainer!=NULL && taskContainer->cb!=cb) {
+      taskContainer = taskContainer->next;
+   }
+   
+   return taskContainer;
+}
+
+/**
+\brief Find a task container for a new task when none is free.
+
+\pre Interrupts are disabled and the free list is empty.
+
+\param prio The priority of the new task.
+
+\returns A container which is neither in a FIFO nor in the free list, or NULL
+         if the new task is to be rejected.
+*/
+taskList_item_t* scheduler_reclaim(task_prio_t prio) {
+#if SCHEDULER_OVERFLOW_POLICY==SCHEDULER_OVERFLOW_DROPLOWEST
+   uint8_t           lowestPrio;
+   
+   // find the lowest priority pending task, if any is in a FIFO
+   lowestPrio = TASKPRIO_MAX-1;
+   while (lowestPrio>0 && (scheduler_vars.readyBitmap & (1<<lowestPrio))==0) {
+      lowestPrio--;
+   }
+   if (lowestPrio>prio && (scheduler_vars.readyBitmap & (1<<lowestPrio))!=0) {
+      // drop its oldest task, the new task takes the container
+      scheduler_dbg.numDropped++;
+      return scheduler_dequeue(lowestPrio);
+   }
+#elif SCHEDULER_OVERFLOW_POLICY==SCHEDULER_OVERFLOW_RESET
+   // we can not print from within the kernel. Instead:
+   // blink the error LED
+   leds_error_blink();
+   // reset the board
+   board_reset();
+#endif
+   
+   return NULL;
+}
+
+/**
+\brief Call overflow_cb, if registered.
+
+\pre Interrupts are enabled.
+*/
+void scheduler_notifyOverflow(task_cbt cb, task_prio_t prio, owerror_t outcome) {
+   if (scheduler_vars.overflow_cb!=NULL) {
+      scheduler_vars.overflow_cb(cb,prio,outcome);
+   }
+}
+
+/**
+\brief Sleep until the next interrupt, or until the next opentimers deadline.
+
+On boards defining BOARD_HAS_SLEEPFOR, the bsp_timer may stop while asleep, and
+the board reports how long it slept. That time is fed back into opentimers,
+which calls the timers expired meanwhile. Other boards simply call
+board_sleep().
+*/
+void scheduler_sleep() {
+#ifdef BOARD_HAS_SLEEPFOR
+   uint32_t sleptTicks;
+   INTERRUPT_DECLARATION();
+
+   sleptTicks = board_sleepFor(opentimers_getTimeToNextDeadline());
+   if (sleptTicks>0) {
+      // timer callbacks expect to be called in interrupt mode
+      DISABLE_INTERRUPTS();
+      opentimers_sleepTimeCompensation(sleptTicks);
+      ENABLE_INTERRUPTS();
+   }
+#else
+   board_sleep();
+#endif
+}
+
+#ifdef SCHEDULER_PROFILING
+/**
+\brief Account for one execution of a callback.
+
+Executed in task context only, as is debugPrint_schedulerProfile(), so the
+profiling table needs no protection against interrupts.
+
+\param cb       The callback which just executed.
+\param duration How long it executed, in SCHEDULER_PROFILE_NOW() ticks.
+*/
+void scheduler_profileTask(task_cbt cb, PORT_TIMER_WIDTH duration) {
+   scheduler_profile_t* entry;
+   uint8_t              i;
+   
+   // find the entry of that callback, or the first unused one
+   for (i=0;i<SCHEDULER_PROFILE_DEPTH;i++) {
+      entry = &scheduler_vars.profile[i];
+      if (entry->cb==cb || entry->cb==NULL) {
+         break;
+      }
+   }
+   if (i==SCHEDULER_PROFILE_DEPTH) {
+      // table is full
+      scheduler_vars.numUnprofiled++;
+      return;
+   }
+   
+   if (entry->cb==NULL) {
+      entry->cb            = cb;
+      entry->minDuration   = duration;
+      entry->maxDuration   = duration;
+   }
+   if (duration<entry->minDuration) {
+      entry->minDuration   = duration;
+   }
+   if (duration>entry->maxDuration) {
+      entry->maxDuration   = duration;
+   }
+   entry->totalDuration   += duration;
+   entry->count++;
+}
+#endif
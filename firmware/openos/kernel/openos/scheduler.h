@@ -23,42 +23,152 @@ typedef enum {
    TASKPRIO_TCP_TIMEOUT        = 0x05, // scheduled by timerB CCR2 interrupt
    TASKPRIO_COAP               = 0x06, // scheduled by timerB CCR3 interrupt
    // tasks trigger by other interrupts
-   TASKPRIO_BUTTON             = 0x07, // scheduled by P2.7 interrupt
+   TASKPRIO_BUTTON             = 0x07, // scheduled by P2.7 interrupt, and the UART RX interrupt
    TASKPRIO_MAX                = 0x08,
 } task_prio_t;
 
 #define TASK_LIST_DEPTH      10
 
+// what scheduler_push_task() does when all TASK_LIST_DEPTH containers are used
+#define SCHEDULER_OVERFLOW_RESET       0 // blink the error LED and reset the board
+#define SCHEDULER_OVERFLOW_REJECT      1 // drop the new task, return E_FAIL
+#define SCHEDULER_OVERFLOW_COALESCE    2 // fold into an identical pending task, else reject
+#define SCHEDULER_OVERFLOW_DROPLOWEST  3 // drop the oldest lower-priority task, else reject
+
+#ifndef SCHEDULER_OVERFLOW_POLICY
+#define SCHEDULER_OVERFLOW_POLICY  SCHEDULER_OVERFLOW_DROPLOWEST
+#endif
+
+// define SCHEDULER_EDF to enable scheduler_push_task_deadline()
+// (on the opentimers clock by default, as opentimers resets the bsp_timer; it
+// runs from opentimers_init() on, also within timer callbacks)
+#ifdef SCHEDULER_EDF
+#ifndef SCHEDULER_DEADLINE_NOW
+#define SCHEDULER_DEADLINE_NOW()   opentimers_getUptime()
+#endif
+#endif
+
+// define SCHEDULER_PROFILING to measure the execution time of each callback
+// (on the bsp_timer counter by default, which opentimers only resets at init
+// and while the scheduler sleeps; callbacks longer than a counter wrap are
+// miscounted)
+#ifdef SCHEDULER_PROFILING
+#define SCHEDULER_PROFILE_DEPTH    16 // number of distinct callbacks profiled
+#ifndef SCHEDULER_PROFILE_NOW
+#define SCHEDULER_PROFILE_NOW()    bsp_timer_get_currentValue()
+#endif
+#endif
+
 //=========================== typedef =========================================
 
 typedef void (*task_cbt)();
 
+/**
+\brief Called after each task list overflow, see scheduler_setOverflowCb().
+
+\param cb      The callback of the task being pushed.
+\param prio    The priority of that task.
+\param outcome E_SUCCESS if SCHEDULER_OVERFLOW_POLICY made room for it, E_FAIL
+               if it was rejected.
+*/
+typedef void (*scheduler_overflow_cbt)(task_cbt cb, task_prio_t prio, owerror_t outcome);
+
 typedef struct task_llist_t {
    task_cbt             cb;
    task_prio_t          prio;
    void*                next;
+#ifdef SCHEDULER_EDF
+   uint32_t             deadline;           // only in deadlineList
+#endif
 } taskList_item_t;
 
+#ifdef SCHEDULER_PROFILING
+/// Execution time statistics of one callback, in timer ticks.
+typedef struct {
+   task_cbt             cb;                 // NULL if this entry is unused
+   uint16_t             count;              // number of executions
+   PORT_TIMER_WIDTH     minDuration;
+   PORT_TIMER_WIDTH     maxDuration;
+   uint32_t             totalDuration;
+} scheduler_profile_t;
+
+/// One scheduler_profile_t entry, as printed over serial.
+typedef struct {
+   uint8_t              index;              // position in the profiling table
+   uint32_t             cb;                 // address of the callback, see map file
+   uint16_t             count;
+   PORT_TIMER_WIDTH     minDuration;
+   PORT_TIMER_WIDTH     maxDuration;
+   uint32_t             totalDuration;
+} scheduler_profile_dbg_t;
+#endif
+
+/// FIFO of pending tasks sharing the same priority.
+typedef struct {
+   taskList_item_t*     head;               // next task to execute
+   taskList_item_t*     tail;               // last task pushed
+} taskFifo_t;
+
 //=========================== module variables ================================
 
+/**
+\brief Scheduler state.
+
+Task containers are taken from a free list and appended to the FIFO of their
+priority. Bit n of readyBitmap is set iff fifo[n] is not empty, so both pushing
+and popping a task take constant time, whatever the depth of the queue.
+
+With SCHEDULER_EDF, tasks pushed with a deadline are kept apart, in
+deadlineList, and execute before the others: earliest deadline first, then by
+priority, then in the order they were pushed.
+
+\note TASKPRIO_MAX must not exceed 8, the width of readyBitmap.
+*/
 typedef struct {
    taskList_item_t      taskBuf[TASK_LIST_DEPTH];
-   taskList_item_t*     task_list;
-   uint8_t              numTasksCur;
-   uint8_t              numTasksMax;
+   taskList_item_t*     freeList;           // unused task containers
+   taskFifo_t           fifo[TASKPRIO_MAX]; // one FIFO per task_prio_t
+   uint8_t              readyBitmap;        // bit set iff that FIFO not empty
+#ifdef SCHEDULER_EDF
+   taskList_item_t*     deadlineList;       // deadline tasks, in execution order
+#endif
+   scheduler_overflow_cbt overflow_cb;      // NULL if nobody is notified
+#ifdef SCHEDULER_PROFILING
+   scheduler_profile_t  profile[SCHEDULER_PROFILE_DEPTH];
+   uint16_t             numUnprofiled;      // executions not fitting in profile
+   uint8_t              profilePrintIdx;    // next profile entry to print
+#endif
 } scheduler_vars_t;
 
 typedef struct {
    uint8_t              numTasksCur;
    uint8_t              numTasksMax;
+   // task list overflows, and how SCHEDULER_OVERFLOW_POLICY resolved them
+   uint16_t             numOverflows;
+   uint16_t             numCoalesced;       // new task folded into a pending one
+   uint16_t             numDropped;         // pending task dropped for the new one
+   uint16_t             numRejected;        // new task dropped, E_FAIL returned
+   // scheduler_push_task_coalesce() calls folded into a pending task
+   uint16_t             numCoalesceHits;
+   // deadline tasks which started executing after their deadline
+   uint16_t             numDeadlineMisses;
 } scheduler_dbg_t;
 
 //=========================== prototypes ======================================
 
 // public functions
-void scheduler_init();
-void scheduler_start();
-void scheduler_push_task(task_cbt task_cb, task_prio_t prio);
+void      scheduler_init();
+void      scheduler_start();
+owerror_t scheduler_push_task(task_cbt task_cb, task_prio_t prio);
+owerror_t scheduler_push_task_coalesce(task_cbt task_cb, task_prio_t prio);
+#ifdef SCHEDULER_EDF
+owerror_t scheduler_push_task_deadline(task_cbt task_cb, task_prio_t prio, uint32_t deadline_ticks);
+#endif
+void      scheduler_setOverflowCb(scheduler_overflow_cbt cb);
+void      scheduler_getDbg(scheduler_dbg_t* dbg);
+#ifdef SCHEDULER_PROFILING
+bool      scheduler_getProfile(scheduler_profile_dbg_t* output);
+#endif
 
 // interrupt handlers
 void isr_ieee154e_newSlot();
@@ -0,0 +1,208 @@
+/**
+\brief Throughput benchmark and cross-check of the HDLC CRC.
+
+This program computes the HDLC CRC of a BENCH_BUF_LEN-byte pseudo-random buffer
+with:
+- crcIteration(), one byte at a time, and
+- crc16_update(), HDLC_CRC_SLICE bytes at a time.
+
+First, NUM_ROUNDS rounds check that both give the same CRC, over a buffer length
+and offset which vary from one round to the next, and that the CRC of the buffer
+followed by its frame check sequence is HDLC_CRCGOOD.
+
+Then, each implementation runs over the whole buffer in batches of
+BENCH_BATCH_ROUNDS rounds, one bsp_timer read per batch, until it has run for
+BENCH_MIN_TICKS ticks or BENCH_MAX_ROUNDS rounds. The throughput is numBytes
+over the number of ticks.
+
+In the end, all LEDs are turned on if all checks passed, only the error LED
+otherwise, and app_dbg is printed in a data frame every APP_WINDOW_TICKS ticks.
+*/
+
+#include "stdint.h"
+#include "string.h"
+#include "openwsn.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "bsp_timer.h"
+// kernel
+#include "scheduler.h"
+// driver modules required
+#include "openhdlc.h"
+#include "openserial.h"
+#include "opentimers.h"
+
+//=========================== defines =========================================
+
+#define NUM_ROUNDS           1000           // cross-check rounds
+#define BENCH_BUF_LEN        128
+#define BENCH_BATCH_ROUNDS   16             // rounds between two timer reads
+#define BENCH_MIN_TICKS      32768          // 1s at 32kHz
+#define BENCH_MAX_ROUNDS     16384
+
+/// Period of the output windows, in ticks.
+#define APP_WINDOW_TICKS     1000
+
+//=========================== variables =======================================
+
+typedef struct {
+   uint8_t              buf[BENCH_BUF_LEN+2]; // data, then frame check sequence
+} app_vars_t;
+
+app_vars_t app_vars;
+
+typedef struct {
+   uint32_t             bytewise_bytes;
+   uint32_t             bytewise_ticks;     // crcIteration(), all rounds
+   uint32_t             update_bytes;
+   uint32_t             update_ticks;       // crc16_update(), all rounds
+   uint16_t             numMismatches;      // crcIteration()!=crc16_update()
+   uint16_t             numBadFcs;          // CRC over data+FCS not HDLC_CRCGOOD
+} app_dbg_t;
+
+app_dbg_t app_dbg;
+
+//=========================== prototypes ======================================
+
+uint16_t bytewise_crc(const uint8_t* buf, uint16_t len);
+void     cb_window();
+void     task_window();
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main() {
+   uint16_t         round;
+   uint16_t         i;
+   uint16_t         lfsr;
+   uint16_t         len;
+   uint16_t         crcUpdate;
+   uint16_t         crcExpected;
+   uint8_t          saved[2];
+   PORT_TIMER_WIDTH startTime;
+
+   board_init();
+
+   // clear local variables
+   memset(&app_vars,0,sizeof(app_vars_t));
+   memset(&app_dbg,0,sizeof(app_dbg_t));
+
+   // fill the buffer, 16-bit Galois LFSR
+   lfsr = 0xace1;
+   for (i=0;i<BENCH_BUF_LEN;i++) {
+      lfsr = (lfsr>>1)^(-(lfsr&1)&0xb400);
+      app_vars.buf[i] = (uint8_t)lfsr;
+   }
+
+   //===== cross-check
+
+   for (round=0;round<NUM_ROUNDS;round++) {
+
+      // every length and alignment
+      len = round%(BENCH_BUF_LEN+1);
+      i   = round%8;
+      if (len+i>BENCH_BUF_LEN) {
+         len = BENCH_BUF_LEN-i;
+      }
+      if (
+            bytewise_crc(&app_vars.buf[i],len)!=
+            crc16_update(HDLC_CRCINIT,&app_vars.buf[i],len)
+         ) {
+         app_dbg.numMismatches++;
+      }
+
+      // frame check sequence
+      memcpy(saved,&app_vars.buf[len],sizeof(saved));
+      crcUpdate = ~crc16_update(HDLC_CRCINIT,app_vars.buf,len);
+      app_vars.buf[len+0] = (crcUpdate>>0)&0xff;
+      app_vars.buf[len+1] = (crcUpdate>>8)&0xff;
+      if (crc16_update(HDLC_CRCINIT,app_vars.buf,len+2)!=HDLC_CRCGOOD) {
+         app_dbg.numBadFcs++;
+      }
+      memcpy(&app_vars.buf[len],saved,sizeof(saved));
+   }
+
+   //===== throughput, whole buffer
+
+   crcExpected = crc16_update(HDLC_CRCINIT,app_vars.buf,BENCH_BUF_LEN);
+
+   bsp_timer_reset();
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         if (bytewise_crc(app_vars.buf,BENCH_BUF_LEN)!=crcExpected) {
+            app_dbg.numMismatches++;
+         }
+      }
+      app_dbg.bytewise_ticks += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.bytewise_bytes += BENCH_BATCH_ROUNDS*BENCH_BUF_LEN;
+   } while (
+         app_dbg.bytewise_ticks<BENCH_MIN_TICKS &&
+         app_dbg.bytewise_bytes<(uint32_t)BENCH_MAX_ROUNDS*BENCH_BUF_LEN
+      );
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         if (crc16_update(HDLC_CRCINIT,app_vars.buf,BENCH_BUF_LEN)!=crcExpected) {
+            app_dbg.numMismatches++;
+         }
+      }
+      app_dbg.update_ticks   += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.update_bytes   += BENCH_BATCH_ROUNDS*BENCH_BUF_LEN;
+   } while (
+         app_dbg.update_ticks<BENCH_MIN_TICKS &&
+         app_dbg.update_bytes<(uint32_t)BENCH_MAX_ROUNDS*BENCH_BUF_LEN
+      );
+
+   if (app_dbg.numMismatches!=0 || app_dbg.numBadFcs!=0) {
+      leds_error_on();
+   } else {
+      leds_all_on();
+   }
+
+   //===== print the results
+
+   scheduler_init();
+   opentimers_init();
+   openserial_init();
+   opentimers_start(APP_WINDOW_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_window);
+   scheduler_start();
+   return 0; // this line should never be reached
+}
+
+//=========================== callbacks =======================================
+
+void cb_window() {
+   scheduler_push_task(task_window,TASKPRIO_COAP);
+}
+
+//=========================== tasks ===========================================
+
+void task_window() {
+   openserial_startOutput();
+   openserial_printData((uint8_t*)&app_dbg,sizeof(app_dbg_t));
+}
+
+//=========================== private =========================================
+
+/**
+\brief Reference CRC, one crcIteration() per byte.
+*/
+uint16_t bytewise_crc(const uint8_t* buf, uint16_t len) {
+   uint16_t crc;
+
+   crc = HDLC_CRCINIT;
+   while (len>0) {
+      crc = crcIteration(crc,*buf);
+      buf++;
+      len--;
+   }
+   return crc;
+}
@@ -0,0 +1,299 @@
+/**
+\brief Fuzz test and benchmark of the bulk HDLC encoder and decoder.
+
+Each of the NUM_ROUNDS fuzzing rounds builds a pseudo-random payload, about one
+byte in sixteen being HDLC_FLAG or HDLC_ESCAPE, and:
+- encodes it with openhdlc_encode(), and with a byte-wise reference encoder,
+  checking they give the same frame,
+- optionally flips one bit of the encoded frame,
+- feeds the frame to openhdlc_decode() in pseudo-random chunks, and checks the
+  payload decoded is the one encoded, or that the flipped frame is rejected.
+
+Then, the last payload of MAX_PAYLOAD_LEN bytes is encoded with both encoders,
+and decoded in BENCH_DECODE_CHUNK-byte chunks, in batches of BENCH_BATCH_ROUNDS
+rounds with one bsp_timer read per batch, until each has run for
+BENCH_MIN_TICKS ticks or BENCH_MAX_ROUNDS rounds.
+
+In the end, all LEDs are turned on if all checks passed, only the error LED
+otherwise, and app_dbg is printed in a data frame every APP_WINDOW_TICKS ticks.
+*/
+
+#include "stdint.h"
+#include "string.h"
+#include "openwsn.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "bsp_timer.h"
+// kernel
+#include "scheduler.h"
+// driver modules required
+#include "openhdlc.h"
+#include "openserial.h"
+#include "opentimers.h"
+
+//=========================== defines =========================================
+
+#define NUM_ROUNDS           1000           // fuzzing rounds
+#define MAX_PAYLOAD_LEN      127
+// worst case: flags, every payload and CRC byte escaped
+#define MAX_FRAME_LEN        (1+2*(MAX_PAYLOAD_LEN+2)+1)
+#define BENCH_DECODE_CHUNK   16             // bytes per openhdlc_decode() call
+#define BENCH_BATCH_ROUNDS   16             // rounds between two timer reads
+#define BENCH_MIN_TICKS      32768          // 1s at 32kHz
+#define BENCH_MAX_ROUNDS     16384
+
+/// Period of the output windows, in ticks.
+#define APP_WINDOW_TICKS     1000
+
+//=========================== variables =======================================
+
+typedef struct {
+   uint16_t             lfsr;
+   uint8_t              payload[MAX_PAYLOAD_LEN];
+   uint8_t              frame[MAX_FRAME_LEN];
+   uint8_t              refFrame[MAX_FRAME_LEN];
+   uint8_t              decoded[MAX_PAYLOAD_LEN+2];
+} app_vars_t;
+
+app_vars_t app_vars;
+
+typedef struct {
+   uint32_t             bytewise_bytes;     // payload bytes through the reference encoder
+   uint32_t             bytewise_ticks;
+   uint32_t             encode_bytes;       // payload bytes through openhdlc_encode()
+   uint32_t             encode_ticks;
+   uint32_t             decode_bytes;       // payload bytes out of openhdlc_decode()
+   uint32_t             decode_ticks;
+   uint16_t             numDecoded;         // frames decoded as encoded
+   uint16_t             numRejected;        // flipped frames rejected
+   uint16_t             numEncodeErrors;    // frame not the reference one
+   uint16_t             numDecodeErrors;    // frame decoded wrong
+} app_dbg_t;
+
+app_dbg_t app_dbg;
+
+//=========================== prototypes ======================================
+
+uint8_t  app_random();
+uint16_t bytewise_encode(uint8_t* dst, const uint8_t* src, uint16_t srcLen);
+void     cb_window();
+void     task_window();
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main() {
+   uint16_t           round;
+   uint16_t           i;
+   uint16_t           payloadLen;
+   uint16_t           frameLen;
+   uint16_t           pos;
+   uint16_t           chunk;
+   bool               flipped;
+   openhdlc_decoder_t decoder;
+   openhdlc_decode_t  outcome;
+   PORT_TIMER_WIDTH   startTime;
+
+   board_init();
+
+   // clear local variables
+   memset(&app_vars,0,sizeof(app_vars_t));
+   memset(&app_dbg,0,sizeof(app_dbg_t));
+   app_vars.lfsr = 0xace1;
+
+   //===== fuzzing
+
+   for (round=0;round<NUM_ROUNDS;round++) {
+
+      // build the payload, full length in the last round
+      payloadLen = app_random()%(MAX_PAYLOAD_LEN+1);
+      if (round==NUM_ROUNDS-1) {
+         payloadLen = MAX_PAYLOAD_LEN;
+      }
+      for (i=0;i<payloadLen;i++) {
+         switch (app_random()%32) {
+            case 0:  app_vars.payload[i] = HDLC_FLAG;      break;
+            case 1:  app_vars.payload[i] = HDLC_ESCAPE;    break;
+            default: app_vars.payload[i] = app_random();   break;
+         }
+      }
+
+      // encode
+      frameLen = bytewise_encode(app_vars.refFrame,app_vars.payload,payloadLen);
+      i = openhdlc_encode(app_vars.frame,sizeof(app_vars.frame),app_vars.payload,payloadLen);
+      if (i!=frameLen || memcmp(app_vars.frame,app_vars.refFrame,frameLen)!=0) {
+         app_dbg.numEncodeErrors++;
+         continue;
+      }
+
+      // corrupt, one round in 8
+      flipped = FALSE;
+      if (app_random()%8==0) {
+         i = 1+app_random()%(frameLen-2);
+         app_vars.frame[i] ^= 1<<(app_random()%8);
+         if (app_vars.frame[i]==HDLC_FLAG) {
+            // would split the frame in two
+            app_vars.frame[i] ^= 0x01;
+         }
+         flipped = TRUE;
+      }
+
+      // decode
+      openhdlc_decoderInit(&decoder,app_vars.decoded,sizeof(app_vars.decoded));
+      outcome = HDLC_DECODE_BUSY;
+      pos     = 0;
+      while (pos<frameLen && outcome==HDLC_DECODE_BUSY) {
+         chunk = 1+app_random()%32;
+         if (chunk>frameLen-pos) {
+            chunk = frameLen-pos;
+         }
+         pos += openhdlc_decode(&decoder,&app_vars.frame[pos],chunk,&outcome);
+      }
+
+      if (flipped==TRUE) {
+         if (outcome==HDLC_DECODE_FRAME) {
+            app_dbg.numDecodeErrors++;
+         } else {
+            app_dbg.numRejected++;
+         }
+      } else if (
+            outcome!=HDLC_DECODE_FRAME ||
+            decoder.len!=payloadLen    ||
+            memcmp(app_vars.decoded,app_vars.payload,payloadLen)!=0
+         ) {
+         app_dbg.numDecodeErrors++;
+      } else {
+         app_dbg.numDecoded++;
+      }
+   }
+
+   //===== throughput, last payload
+
+   bsp_timer_reset();
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         bytewise_encode(app_vars.refFrame,app_vars.payload,MAX_PAYLOAD_LEN);
+      }
+      app_dbg.bytewise_ticks += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.bytewise_bytes += BENCH_BATCH_ROUNDS*MAX_PAYLOAD_LEN;
+   } while (
+         app_dbg.bytewise_ticks<BENCH_MIN_TICKS &&
+         app_dbg.bytewise_bytes<(uint32_t)BENCH_MAX_ROUNDS*MAX_PAYLOAD_LEN
+      );
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         frameLen = openhdlc_encode(app_vars.frame,sizeof(app_vars.frame),app_vars.payload,MAX_PAYLOAD_LEN);
+      }
+      app_dbg.encode_ticks   += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.encode_bytes   += BENCH_BATCH_ROUNDS*MAX_PAYLOAD_LEN;
+   } while (
+         app_dbg.encode_ticks<BENCH_MIN_TICKS &&
+         app_dbg.encode_bytes<(uint32_t)BENCH_MAX_ROUNDS*MAX_PAYLOAD_LEN
+      );
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         openhdlc_decoderInit(&decoder,app_vars.decoded,sizeof(app_vars.decoded));
+         outcome = HDLC_DECODE_BUSY;
+         pos     = 0;
+         while (pos<frameLen && outcome==HDLC_DECODE_BUSY) {
+            chunk = BENCH_DECODE_CHUNK;
+            if (chunk>frameLen-pos) {
+               chunk = frameLen-pos;
+            }
+            pos += openhdlc_decode(&decoder,&app_vars.frame[pos],chunk,&outcome);
+         }
+         if (outcome==HDLC_DECODE_FRAME) {
+            app_dbg.decode_bytes += decoder.len;
+         } else {
+            app_dbg.numDecodeErrors++;
+         }
+      }
+      app_dbg.decode_ticks   += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+   } while (
+         app_dbg.decode_ticks<BENCH_MIN_TICKS &&
+         app_dbg.decode_bytes<(uint32_t)BENCH_MAX_ROUNDS*MAX_PAYLOAD_LEN &&
+         app_dbg.numDecodeErrors==0
+      );
+
+   if (app_dbg.numEncodeErrors!=0 || app_dbg.numDecodeErrors!=0) {
+      leds_error_on();
+   } else {
+      leds_all_on();
+   }
+
+   //===== print the results
+
+   scheduler_init();
+   opentimers_init();
+   openserial_init();
+   opentimers_start(APP_WINDOW_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_window);
+   scheduler_start();
+   return 0; // this line should never be reached
+}
+
+//=========================== callbacks =======================================
+
+void cb_window() {
+   scheduler_push_task(task_window,TASKPRIO_COAP);
+}
+
+//=========================== tasks ===========================================
+
+void task_window() {
+   openserial_startOutput();
+   openserial_printData((uint8_t*)&app_dbg,sizeof(app_dbg_t));
+}
+
+//=========================== private =========================================
+
+/**
+\brief Next pseudo-random byte, 16-bit Galois LFSR.
+*/
+uint8_t app_random() {
+   app_vars.lfsr = (app_vars.lfsr>>1)^(-(app_vars.lfsr&1)&0xb400);
+   return (uint8_t)app_vars.lfsr;
+}
+
+/**
+\brief Reference encoder, one crcIteration() and escaping test per byte, as
+   openserial used to do.
+*/
+uint16_t bytewise_encode(uint8_t* dst, const uint8_t* src, uint16_t srcLen) {
+   uint16_t dstLen;
+   uint16_t crc;
+   uint16_t i;
+   uint8_t  b;
+
+   dstLen        = 0;
+   crc           = HDLC_CRCINIT;
+   dst[dstLen++] = HDLC_FLAG;
+   for (i=0;i<srcLen+2;i++) {
+      if (i<srcLen) {
+         b   = src[i];
+         crc = crcIteration(crc,b);
+      } else if (i==srcLen) {
+         crc = ~crc;
+         b   = (crc>>0)&0xff;
+      } else {
+         b   = (crc>>8)&0xff;
+      }
+      if (b==HDLC_FLAG || b==HDLC_ESCAPE) {
+         dst[dstLen++] = HDLC_ESCAPE;
+         b             = b^HDLC_ESCAPE_MASK;
+      }
+      dst[dstLen++] = b;
+   }
+   dst[dstLen++] = HDLC_FLAG;
+   return dstLen;
+}
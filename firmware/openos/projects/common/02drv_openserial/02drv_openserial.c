@@ -4,72 +4,207 @@
 Since the driver modules for different platforms have the same declaration, you
 can use this project with any platform.
 
+A periodic timer opens an output window every APP_WINDOW_TICKS ticks. In
+full-duplex mode (SERIAL_FULL_DUPLEX), the mote echoes back the frames the PC
+sends with the SERFRAME_PC2MOTE_TRIGGERSERIALECHO command.
+
+With APP_BENCH, the mote also benchmarks openserial, printing data frames in
+three phases of APP_BENCH_NUM_FRAMES frames each:
+- BENCH_PHASE_RANDOM: pseudo-random payloads, as many as the output queue
+  takes, to measure the sustained mote->PC throughput,
+- BENCH_PHASE_ESCAPE: payloads of only HDLC_FLAG and HDLC_ESCAPE bytes, to
+  measure the escaping overhead,
+- BENCH_PHASE_OVERLOAD: APP_BENCH_OVERLOAD_BURST frames per window, more than
+  the link carries, to measure the frame loss.
+
+Each payload starts with the phase and a 16-bit sequence number (little-endian).
+In the overload phase, the sequence number counts the frames the mote tried to
+print, so the PC counts the lost ones from the gaps. Each phase ends with a
+frame of sequence number BENCH_SEQ_DONE. Once the phases are over, all LEDs are
+turned on; the PC measures the command round-trip time with echo frames.
+
+On the python board, projects/python/bench_openserial.py emulates the UART link
+and prints the results.
+
 \author Xavi Vilajosana <xvilajosana@eecs.berkeley.edu>, January 2013.
 */
 
 #include "stdint.h"
-#include "stdio.h"
+#include "string.h"
+#include "openwsn.h"
 // bsp modules required
 #include "board.h"
 #include "leds.h"
-#include "uart.h"
-
+// kernel
+#include "scheduler.h"
 // driver modules required
+#include "openhdlc.h"
 #include "openserial.h"
+#include "opentimers.h"
 
 //=========================== defines =========================================
 
+/// Period of the output windows, in ticks.
+#define APP_WINDOW_TICKS          100
+
+/// Whether to run the benchmark phases; 0 only echoes the frames from the PC.
+#ifndef APP_BENCH
+#define APP_BENCH                 1
+#endif
+
+#define APP_BENCH_NUM_FRAMES      1000       // frames per phase
+#define APP_BENCH_PAYLOAD_LEN     64         // bytes, phase and sequence number included
+#define APP_BENCH_OVERLOAD_BURST  2          // frames per window in the overload phase
+
+#define BENCH_SEQ_DONE            0xffff
+
+enum {
+   BENCH_PHASE_RANDOM             = 0,
+   BENCH_PHASE_ESCAPE             = 1,
+   BENCH_PHASE_OVERLOAD           = 2,
+   BENCH_PHASE_DONE               = 3,
+};
 
 //=========================== variables =======================================
 
+typedef struct {
+   uint8_t              phase;
+   uint16_t             seq;                // next sequence number
+   uint16_t             lfsr;               // pseudo-random payloads
+   uint8_t              payload[APP_BENCH_PAYLOAD_LEN];
+} app_vars_t;
+
+app_vars_t app_vars;
+
+typedef struct {
+   uint32_t             numWindows;
+   uint16_t             numPrinted[BENCH_PHASE_DONE];  // frames in the output queue
+   uint16_t             numFailed[BENCH_PHASE_DONE];   // output queue full
+} app_dbg_t;
+
+app_dbg_t app_dbg;
 
 //=========================== prototypes ======================================
-void isr_serie_tx();
-void isr_serie_rx();
+
+void      cb_window();
+void      task_window();
+void      bench_produce();
+owerror_t bench_print(uint16_t seq);
 
 //=========================== main ============================================
 
 /**
 \brief The program starts executing here.
-in order to echo chunks of bytes, each chunk needs to start with character 'H' as
-openserial takes different actions according to the initial character of the stream.
 */
-int mote_main() {  
+int mote_main() {
    board_init();
+   scheduler_init();
+   opentimers_init();
    openserial_init();
    
-   uart_clearTxInterrupts();
-   uart_clearRxInterrupts();          // clear possible pending interrupts
-   uart_enableInterrupts(); 
-  
-   openserial_startInput();
-      
-   while(1) {
-      board_sleep();
-   }
+   memset(&app_vars,0,sizeof(app_vars_t));
+   memset(&app_dbg,0,sizeof(app_dbg_t));
+   app_vars.lfsr        = 0xace1;
+#if APP_BENCH
+   app_vars.phase       = BENCH_PHASE_RANDOM;
+#else
+   app_vars.phase       = BENCH_PHASE_DONE;
+#endif
+   
+   opentimers_start(APP_WINDOW_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_window);
+   
+   scheduler_start();
+   return 0; // this line should never be reached
 }
 
 //=========================== callbacks =======================================
 
-void isr_serie_tx(){
-  leds_all_toggle();
-  uart_clearTxInterrupts();
-  uart_clearRxInterrupts();          // clear possible pending interrupts
-  uart_enableInterrupts(); 
-  
-  openserial_startInput();
- }
-
-
-void isr_serie_rx(){
-  uint8_t bytes;
-  uint8_t bufferToWrite[136];
-  
-  leds_all_toggle();
-  bytes=openserial_getNumDataBytes();
-  openserial_getInputBuffer(bufferToWrite, bytes);
-  
-  openserial_printData(bufferToWrite, bytes);
-  openserial_startOutput();
-  
-}
\ No newline at end of file
+void cb_window() {
+   scheduler_push_task(task_window,TASKPRIO_COAP);
+}
+
+//=========================== tasks ===========================================
+
+void task_window() {
+   app_dbg.numWindows++;
+   
+   openserial_startOutput();
+   if (app_vars.phase<BENCH_PHASE_DONE) {
+      bench_produce();
+   }
+}
+
+//=========================== private =========================================
+
+/**
+\brief Print the data frames of the current benchmark phase, for one window.
+*/
+void bench_produce() {
+   uint8_t numTries;
+   
+   if (app_vars.seq==APP_BENCH_NUM_FRAMES) {
+      // end of the phase, retried until the output queue takes it
+      if (bench_print(BENCH_SEQ_DONE)==E_SUCCESS) {
+         app_vars.phase++;
+         app_vars.seq = 0;
+         if (app_vars.phase==BENCH_PHASE_DONE) {
+            leds_all_on();
+         }
+      }
+      return;
+   }
+   
+   if (app_vars.phase==BENCH_PHASE_OVERLOAD) {
+      // every frame gets a sequence number, printed or not
+      for (numTries=0;numTries<APP_BENCH_OVERLOAD_BURST;numTries++) {
+         bench_print(app_vars.seq);
+         app_vars.seq++;
+         if (app_vars.seq==APP_BENCH_NUM_FRAMES) {
+            break;
+         }
+      }
+   } else {
+      // as many frames as the output queue takes
+      while (app_vars.seq<APP_BENCH_NUM_FRAMES) {
+         if (bench_print(app_vars.seq)!=E_SUCCESS) {
+            break;
+         }
+         app_vars.seq++;
+      }
+   }
+}
+
+/**
+\brief Print one data frame of the current benchmark phase.
+
+\param[in] seq The sequence number of the frame.
+
+\returns E_SUCCESS if the frame is in the output queue, E_FAIL otherwise.
+*/
+owerror_t bench_print(uint16_t seq) {
+   uint8_t   i;
+   owerror_t outcome;
+   
+   app_vars.payload[0] = app_vars.phase;
+   app_vars.payload[1] = (seq>>0)&0xff;
+   app_vars.payload[2] = (seq>>8)&0xff;
+   for (i=3;i<APP_BENCH_PAYLOAD_LEN;i++) {
+      if (app_vars.phase==BENCH_PHASE_ESCAPE) {
+         app_vars.payload[i] = (i&0x01) ? HDLC_ESCAPE : HDLC_FLAG;
+      } else {
+         // 16-bit Galois LFSR
+         app_vars.lfsr = (app_vars.lfsr>>1)^(-(app_vars.lfsr&1)&0xb400);
+         app_vars.payload[i] = (uint8_t)app_vars.lfsr;
+      }
+   }
+   
+   outcome = openserial_printData(app_vars.payload,APP_BENCH_PAYLOAD_LEN);
+   if (outcome==E_SUCCESS) {
+      app_dbg.numPrinted[app_vars.phase]++;
+   } else {
+      app_dbg.numFailed[app_vars.phase]++;
+   }
+   return outcome;
+}
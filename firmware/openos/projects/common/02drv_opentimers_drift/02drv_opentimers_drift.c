@@ -0,0 +1,99 @@
+/**
+\brief Long-run phase test of periodic "opentimers" timers.
+
+A periodic timer toggles the error LED every APP_PERIOD_TICKS ticks. A one-shot
+timer of pseudo-random duration is restarted over and over, which keeps
+re-scheduling the hardware timer in between periods, and toggles the radio
+LED.
+
+Since periodic timers are reloaded at their previous expiry plus their period,
+the N-th toggle of the error LED happens N*APP_PERIOD_TICKS ticks after the
+first one, up to the interrupt latency, whatever N. On the python board,
+projects/python/test_opentimers_drift.py runs this for 1M periods and checks
+that the phase error does not accumulate.
+*/
+
+#include "stdint.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+// driver modules required
+#include "opentimers.h"
+
+//=========================== defines =========================================
+
+#define APP_PERIOD_TICKS     1000
+#define APP_JITTER_MASK      0x07ff         // one-shot timers last 1..2048 ticks
+
+//=========================== variables =======================================
+
+typedef struct {
+   opentimer_id_t       periodicId;
+   opentimer_id_t       jitterId;
+   uint16_t             lfsr;               // pseudo-random jitter durations
+   uint32_t             numPeriods;
+   uint32_t             numJitters;
+} app_vars_t;
+
+app_vars_t app_vars;
+
+//=========================== prototypes ======================================
+
+void     cb_periodic();
+void     cb_jitter();
+void     restartJitter();
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main() {
+   board_init();
+   opentimers_init();
+
+   memset(&app_vars,0,sizeof(app_vars_t));
+   app_vars.lfsr        = 0xace1;
+   app_vars.jitterId    = TOO_MANY_TIMERS_ERROR;
+
+   app_vars.periodicId  = opentimers_start(APP_PERIOD_TICKS,
+                                           TIMER_PERIODIC,TIME_TICS,
+                                           cb_periodic);
+   restartJitter();
+
+   while(1) {
+      board_sleep();
+   }
+}
+
+//=========================== callbacks =======================================
+
+void cb_periodic() {
+   app_vars.numPeriods++;
+   leds_error_toggle();
+   restartJitter();
+}
+
+void cb_jitter() {
+   app_vars.numJitters++;
+   leds_radio_toggle();
+   restartJitter();
+}
+
+//=========================== private =========================================
+
+/**
+\brief Replace the one-shot timer by one of a new pseudo-random duration.
+*/
+void restartJitter() {
+   // 16-bit Galois LFSR
+   app_vars.lfsr = (app_vars.lfsr>>1)^(-(app_vars.lfsr&1)&0xb400);
+
+   if (app_vars.jitterId!=TOO_MANY_TIMERS_ERROR) {
+      opentimers_stop(app_vars.jitterId);
+   }
+   app_vars.jitterId = opentimers_start((app_vars.lfsr&APP_JITTER_MASK)+1,
+                                        TIMER_ONESHOT,TIME_TICS,
+                                        cb_jitter);
+}
@@ -0,0 +1,223 @@
+/**
+\brief Micro-benchmark of the OpenOS scheduler task queue.
+
+This program times pushing and popping tasks through:
+- the scheduler's priority-bitmap queue (scheduler_push_task() and the
+  scheduler's internal pop), and
+- a local copy of the former implementation, which scanned taskBuf for a free
+  container and inserted in a priority-sorted linked list.
+
+Each round pushes TASK_LIST_DEPTH tasks of mixed priorities, then pops them all.
+A single round lasts far less than a bsp_timer tick, so rounds are timed in
+batches of BENCH_BATCH_ROUNDS, until an implementation has run for
+BENCH_MIN_TICKS ticks, or BENCH_MAX_ROUNDS rounds. The cost of a round is the
+number of ticks over the number of rounds.
+
+Once done, the mote turns all LEDs on, starts the scheduler and prints app_dbg,
+as laid out in memory, in a data frame every APP_WINDOW_TICKS ticks. Boards whose
+bsp_timer does not advance while the CPU runs (e.g. the python board) report 0
+ticks after BENCH_MAX_ROUNDS rounds.
+*/
+
+#include "stdint.h"
+#include "string.h"
+#include "openwsn.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "bsp_timer.h"
+// kernel
+#include "scheduler.h"
+// driver modules required
+#include "openserial.h"
+#include "opentimers.h"
+
+//=========================== defines =========================================
+
+#define BENCH_BATCH_ROUNDS   64             // rounds between two timer reads
+#define BENCH_MIN_TICKS      32768          // 1s at 32kHz
+#define BENCH_MAX_ROUNDS     65536
+
+/// Period of the output windows, in ticks.
+#define APP_WINDOW_TICKS     1000
+
+//=========================== variables =======================================
+
+typedef struct {
+   taskList_item_t      taskBuf[TASK_LIST_DEPTH];
+   taskList_item_t*     task_list;
+} legacy_vars_t;
+
+legacy_vars_t legacy_vars;
+
+typedef struct {
+   uint32_t             numTaskCalls;
+   uint32_t             bitmap_rounds;
+   uint32_t             bitmap_ticks;       // priority-bitmap queue, all rounds
+   uint32_t             legacy_rounds;
+   uint32_t             legacy_ticks;       // sorted linked list, all rounds
+} app_dbg_t;
+
+app_dbg_t app_dbg;
+
+// mix of priorities, in push order
+static const task_prio_t pushPrios[TASK_LIST_DEPTH] = {
+   TASKPRIO_BUTTON,
+   TASKPRIO_COAP,
+   TASKPRIO_RES,
+   TASKPRIO_RESNOTIF_RX,
+   TASKPRIO_COAP,
+   TASKPRIO_RPL,
+   TASKPRIO_TCP_TIMEOUT,
+   TASKPRIO_RESNOTIF_TXDONE,
+   TASKPRIO_RES,
+   TASKPRIO_BUTTON,
+};
+
+//=========================== prototypes ======================================
+
+// private to the scheduler, called directly here to time it
+task_cbt scheduler_popTask();
+
+void     legacy_push_task(task_cbt cb, task_prio_t prio);
+task_cbt legacy_pop_task();
+void     cb_task();
+void     cb_window();
+void     task_window();
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main() {
+   uint16_t         round;
+   uint8_t          i;
+   PORT_TIMER_WIDTH startTime;
+   task_cbt         cb;
+
+   board_init();
+   scheduler_init();
+
+   // clear local variables
+   memset(&legacy_vars,0,sizeof(legacy_vars_t));
+   memset(&app_dbg,0,sizeof(app_dbg_t));
+
+   bsp_timer_reset();
+
+   //===== priority-bitmap queue
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         for (i=0;i<TASK_LIST_DEPTH;i++) {
+            scheduler_push_task(cb_task,pushPrios[i]);
+         }
+         for (i=0;i<TASK_LIST_DEPTH;i++) {
+            cb = scheduler_popTask();
+            cb();
+         }
+      }
+      app_dbg.bitmap_ticks  += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.bitmap_rounds += BENCH_BATCH_ROUNDS;
+   } while (app_dbg.bitmap_ticks<BENCH_MIN_TICKS && app_dbg.bitmap_rounds<BENCH_MAX_ROUNDS);
+
+   //===== sorted linked list
+
+   do {
+      startTime = bsp_timer_get_currentValue();
+      for (round=0;round<BENCH_BATCH_ROUNDS;round++) {
+         for (i=0;i<TASK_LIST_DEPTH;i++) {
+            legacy_push_task(cb_task,pushPrios[i]);
+         }
+         for (i=0;i<TASK_LIST_DEPTH;i++) {
+            cb = legacy_pop_task();
+            cb();
+         }
+      }
+      app_dbg.legacy_ticks  += (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-startTime);
+      app_dbg.legacy_rounds += BENCH_BATCH_ROUNDS;
+   } while (app_dbg.legacy_ticks<BENCH_MIN_TICKS && app_dbg.legacy_rounds<BENCH_MAX_ROUNDS);
+
+   leds_all_on();
+
+   //===== print the results
+
+   opentimers_init();
+   openserial_init();
+   opentimers_start(APP_WINDOW_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_window);
+   scheduler_start();
+   return 0; // this line should never be reached
+}
+
+//=========================== callbacks =======================================
+
+void cb_task() {
+   app_dbg.numTaskCalls++;
+}
+
+void cb_window() {
+   scheduler_push_task(task_window,TASKPRIO_COAP);
+}
+
+//=========================== tasks ===========================================
+
+void task_window() {
+   openserial_startOutput();
+   openserial_printData((uint8_t*)&app_dbg,sizeof(app_dbg_t));
+}
+
+//=========================== private =========================================
+
+/**
+\brief Former scheduler_push_task(): linear search, then sorted insertion.
+*/
+void legacy_push_task(task_cbt cb, task_prio_t prio) {
+   taskList_item_t*  taskContainer;
+   taskList_item_t** taskListWalker;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   // find an empty task container
+   taskContainer = &legacy_vars.taskBuf[0];
+   while (taskContainer->cb!=NULL &&
+          taskContainer<=&legacy_vars.taskBuf[TASK_LIST_DEPTH-1]) {
+      taskContainer++;
+   }
+   // fill that task container with this task
+   taskContainer->cb              = cb;
+   taskContainer->prio            = prio;
+
+   // find position in queue
+   taskListWalker                 = &legacy_vars.task_list;
+   while (*taskListWalker!=NULL &&
+          (*taskListWalker)->prio < taskContainer->prio) {
+      taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
+   }
+   // insert at that position
+   taskContainer->next            = *taskListWalker;
+   *taskListWalker                = taskContainer;
+
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Former scheduler_start() loop body: pop the head of the list.
+*/
+task_cbt legacy_pop_task() {
+   taskList_item_t* pThisTask;
+   task_cbt         cb;
+
+   pThisTask                      = legacy_vars.task_list;
+   legacy_vars.task_list          = pThisTask->next;
+   cb                             = pThisTask->cb;
+
+   pThisTask->cb                  = NULL;
+   pThisTask->prio                = TASKPRIO_NONE;
+   pThisTask->next                = NULL;
+
+   return cb;
+}
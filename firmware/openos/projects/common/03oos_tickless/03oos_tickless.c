@@ -0,0 +1,101 @@
+/**
+\brief Tickless idle test of the OpenOS scheduler and "opentimers" timers.
+
+Three periodic timers run:
+- the short timer (APP_SHORT_TICKS) pushes a task which toggles the error LED,
+- the long timer (APP_LONG_TICKS) is longer than the 16-bit bsp_timer counter,
+  and toggles the radio LED,
+- the slack timer (APP_SLACK_PERIOD_TICKS) may fire up to APP_SLACK_TICKS late,
+  and toggles the sync LED.
+
+On boards defining BOARD_HAS_SLEEPFOR, scheduler_start() sleeps until the next
+timer deadline with board_sleepFor(), and compensates the timers for the time
+the bsp_timer counter missed; other boards idle in board_sleep(). On the python
+board, projects/python/test_tickless.py emulates a board whose counter
+stops in deep sleep, checks the time of every toggle, and reports the fraction
+of time spent asleep.
+*/
+
+#include "stdint.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+// kernel
+#include "scheduler.h"
+// driver modules required
+#include "opentimers.h"
+
+//=========================== defines =========================================
+
+#define APP_SHORT_TICKS          1000
+#define APP_LONG_TICKS           100000     // more than a 16-bit counter
+#define APP_SLACK_PERIOD_TICKS   3000
+#define APP_SLACK_TICKS          500
+
+//=========================== variables =======================================
+
+typedef struct {
+   uint32_t             numShort;
+   uint32_t             numLong;
+   uint32_t             numSlack;
+} app_vars_t;
+
+app_vars_t app_vars;
+
+//=========================== prototypes ======================================
+
+void     cb_short();
+void     cb_long();
+void     cb_slack();
+void     task_short();
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main() {
+   board_init();
+   scheduler_init();
+   opentimers_init();
+
+   memset(&app_vars,0,sizeof(app_vars_t));
+
+   opentimers_start(APP_SHORT_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_short);
+   opentimers_start(APP_LONG_TICKS,
+                    TIMER_PERIODIC,TIME_TICS,
+                    cb_long);
+   opentimers_start_with_slack(APP_SLACK_PERIOD_TICKS,
+                               APP_SLACK_TICKS,
+                               TIMER_PERIODIC,TIME_TICS,
+                               cb_slack);
+
+   scheduler_start();
+   return 0; // this line should never be reached
+}
+
+//=========================== callbacks =======================================
+
+void cb_short() {
+   scheduler_push_task(task_short,TASKPRIO_COAP);
+}
+
+void cb_long() {
+   app_vars.numLong++;
+   leds_radio_toggle();
+}
+
+void cb_slack() {
+   app_vars.numSlack++;
+   leds_sync_toggle();
+}
+
+//=========================== tasks ===========================================
+
+void task_short() {
+   app_vars.numShort++;
+   leds_error_toggle();
+}
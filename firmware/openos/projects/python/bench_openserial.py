@@ -0,0 +1,457 @@
+'''
+Throughput and latency benchmark of openserial on the python board.
+
+Runs the 02drv_openserial project, with APP_BENCH, on an emulated telosb-like
+bsp_timer and a full-duplex UART link of BAUDRATE bauds (10 bits per byte).
+The mote prints data frames in three phases:
+- random:   pseudo-random payloads, as fast as the link takes them,
+- escape:   payloads of only 0x7e/0x7d bytes, all of which HDLC escapes,
+- overload: more frames than the link carries.
+Then the PC sends NUM_ECHOES echo commands, one at a time, and times the echo
+frames. With --cobs, the PC first asks for COBS framing, which the module must
+be built with (SERIAL_COBS in openserial.h). With --native, the bsp_timer and the
+UART are emulated in C (see OpenMote.set_native()), and Python is only called
+for the buffers the mote writes; the debugpins and leds notifications are logged,
+and drained once per buffer.
+
+The PC sends its commands whenever it wants, so the module must be built in
+full-duplex mode (SERIAL_FULL_DUPLEX in openserial.h). Build the module first:
+   scons board=python toolchain=gcc drv_openserial
+
+Prints one "key=value" line per phase, times in emulated time, then a summary
+line. Exits with 0 iff no frame was corrupted, the random and escape phases
+lost no frame, and every echo came back.
+
+Usage:
+   python bench_openserial.py [--baudrate 115200] [--cobs] [--native]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains the module
+
+import re
+import time
+
+from opentrace_decode import Deframer, crc16, HDLC_FLAG, HDLC_ESCAPE, HDLC_ESCAPE_MASK, HDLC_CRCINIT
+
+COUNTER_MAX        = 0x10000
+TICKS_PER_S        = 32768
+BAUDRATE           = 115200
+MAX_SIM_TICKS      = 100*TICKS_PER_S
+
+# as in 02drv_openserial.c
+NUM_FRAMES         = 1000       # APP_BENCH_NUM_FRAMES
+PAYLOAD_LEN        = 64         # APP_BENCH_PAYLOAD_LEN
+SEQ_DONE           = 0xffff     # BENCH_SEQ_DONE
+PHASES             = ['random','escape','overload']
+PHASE_ECHO         = 3          # BENCH_PHASE_DONE, the echo frames start with it
+
+# the BSP modules OpenMote.set_native() emulates in C
+NATIVE_MODULES     = ['board','bsp_timer','debugpins','leds','uart']
+# the notifications logged with --native, see OpenMote.set_event_log()
+LOGGED_MODULES     = ['debugpins','leds']
+EVENT_RECORD_LEN   = 6          # EVENTLOG_RECORD_LEN
+
+NUM_ECHOES         = 100
+ECHO_LEN           = 16         # bytes echoed, phase and sequence number included
+
+SERFRAME_DATA      = ord('D')
+SERFRAME_ECHO      = ord('S')
+SERFRAME_FRAMING   = ord('F')   # both ways
+FRAMINGS           = ['hdlc','cobs'] # SERIAL_FRAMING_*
+DATA_HEADER_LEN    = 8          # type, address (2B), ASN (5B)
+
+#============================ get notification IDs ============================
+
+f = open(os.path.join('..','..','bsp','boards','python','openwsnmodule_obj.h'))
+lines = f.readlines()
+f.close()
+
+notifString = []
+
+for line in lines:
+    m = re.search('MOTE_NOTIF_(\w+)',line)
+    if m:
+        if m.group(1) not in notifString:
+            notifString += [m.group(1)]
+
+def notifId(s):
+    assert s in notifString
+    return notifString.index(s)
+
+import drv_openserial
+
+#============================ emulated bsp_timer ==============================
+
+class BspTimer(object):
+
+    def __init__(self):
+        self.now                  = 0   # absolute simulated time, in ticks, not an integer
+        self.resetTime            = 0
+        self.lastCompare          = 0
+        self.fireTime             = None
+
+    def counter(self):
+        return int(self.now-self.resetTime)%COUNTER_MAX
+
+    def reset(self):
+        self.resetTime            = self.now
+        self.lastCompare          = 0
+        self.fireTime             = None
+
+    def scheduleIn(self,delay):
+        elapsed                   = (self.counter()-self.lastCompare)%COUNTER_MAX
+        self.lastCompare          = (self.lastCompare+delay)%COUNTER_MAX
+        if delay<=elapsed:
+            # too late, fires right away
+            self.fireTime         = self.now
+        else:
+            self.fireTime         = self.now+(self.lastCompare-self.counter())%COUNTER_MAX
+
+    def cancel_schedule(self):
+        self.fireTime             = None
+
+    def get_currentValue(self):
+        return self.counter()
+
+#============================ emulated UART ===================================
+
+class Uart(object):
+    '''
+    Full-duplex UART link; a byte takes byteTicks in each direction.
+    '''
+
+    def __init__(self,timer,baudrate):
+        self.timer                = timer
+        self.byteTicks            = 10.0*TICKS_PER_S/baudrate
+        self.txBuf                = None
+        self.txStart              = None
+        self.txDoneTime           = None
+        self.rxBytes              = []
+        self.rxNextTime           = None
+        self.rxByte               = 0
+
+    def writeBuffer(self,buf):
+        assert self.txBuf==None
+        self.txBuf                = buf
+        self.txStart              = self.timer.now
+        self.txDoneTime           = self.timer.now+len(buf)*self.byteTicks
+
+    def writeByte(self,b):
+        self.writeBuffer([b])
+
+    def readByte(self):
+        return self.rxByte
+
+    def now(self):
+        return self.timer.now
+
+    def send(self,buf):
+        '''
+        Queue bytes to the mote, returns the time the last one arrives.
+        '''
+        if self.rxNextTime==None:
+            self.rxNextTime       = self.timer.now+self.byteTicks
+        self.rxBytes             += buf
+        return self.rxNextTime+(len(self.rxBytes)-1)*self.byteTicks
+
+class NativeUart(object):
+    '''
+    The UART of the native BSP, emulated in C; same interface as Uart.
+    '''
+
+    def __init__(self,mote,baudrate):
+        self.mote                 = mote
+        self.byteTicks            = 10.0*TICKS_PER_S/baudrate
+        self.txBuf                = None
+        self.txStart              = None
+        self.txDone               = None   # called for each buffer the mote writes
+
+    def writeBuffer(self,buf):
+        # the bytes are also in the C buffer, take them from there
+        self.txBuf                = bytearray(self.mote.uart_tx_read())
+        self.txStart              = self.mote.get_time()
+        self.txDone()
+
+    def send(self,buf):
+        return self.mote.uart_rx_write(str(bytearray(buf)))
+
+    def now(self):
+        return self.mote.get_time()
+
+#============================ benchmark =======================================
+
+class PhaseStats(object):
+
+    def __init__(self,name):
+        self.name                 = name
+        self.numFrames            = 0
+        self.maxSeq               = -1
+        self.numGaps              = 0
+        self.payloadBytes         = 0
+        self.frameBytes           = 0   # unescaped, flags and CRC included
+        self.wireBytes            = 0
+        self.firstStart           = None
+        self.lastEnd              = None
+        self.done                 = False
+        self.wallStart            = None
+        self.wallEnd              = None
+
+    def frame(self,seq,payloadLen,frameLen,wireLen,start,end):
+        if self.firstStart==None:
+            self.firstStart       = start
+            self.wallStart        = time.time()
+        if seq>self.maxSeq+1:
+            self.numGaps         += seq-self.maxSeq-1
+        self.maxSeq               = max(self.maxSeq,seq)
+        self.numFrames           += 1
+        self.payloadBytes        += payloadLen
+        self.frameBytes          += frameLen
+        self.wireBytes           += wireLen
+        self.lastEnd              = end
+
+    def output(self,byteTicks):
+        seconds                   = float(self.lastEnd-self.firstStart)/TICKS_PER_S
+        linkBytes                 = (self.lastEnd-self.firstStart)/byteTicks
+        numLost                   = NUM_FRAMES-self.numFrames
+        output                    = []
+        output                   += ['phase={0}'.format(self.name)]
+        output                   += ['frames={0}'.format(self.numFrames)]
+        output                   += ['lost={0}'.format(numLost)]
+        output                   += ['loss_ratio={0:.4f}'.format(float(numLost)/NUM_FRAMES)]
+        output                   += ['seq_gaps={0}'.format(self.numGaps)]
+        output                   += ['payload_bytes={0}'.format(self.payloadBytes)]
+        output                   += ['wire_bytes={0}'.format(self.wireBytes)]
+        output                   += ['payload_bytes_per_s={0:.1f}'.format(self.payloadBytes/seconds)]
+        output                   += ['wire_bytes_per_s={0:.1f}'.format(self.wireBytes/seconds)]
+        output                   += ['link_use={0:.4f}'.format(self.wireBytes/linkBytes)]
+        output                   += ['escape_overhead={0:.4f}'.format(float(self.wireBytes)/self.frameBytes-1)]
+        output                   += ['wall_s={0:.3f}'.format(self.wallEnd-self.wallStart)]
+        return ' '.join(output)
+
+class OpenserialBench(object):
+
+    def __init__(self,mote,timer,uart):
+        self.mote                 = mote
+        self.timer                = timer
+        self.uart                 = uart
+        self.deframer             = Deframer()
+        self.phases               = [PhaseStats(name) for name in PHASES]
+        self.numOtherFrames       = 0
+        self.otherWireBytes       = 0
+        self.echoSeq              = None
+        self.echoSent             = None
+        self.rtts                 = []
+        self.framing              = 'hdlc'
+        self.failure              = None
+        self.numEvents            = 0
+
+    def setFraming(self,framing):
+        self.uart.send(hdlcify([SERFRAME_FRAMING,FRAMINGS.index(framing)]))
+
+    #======================== mote callbacks
+
+    def board_sleepFor(self,maxTicks):
+        events                    = [t for t in [self.timer.fireTime,self.uart.txDoneTime,self.uart.rxNextTime] if t!=None]
+        assert events
+        self.timer.now            = max(self.timer.now,min(events))
+        if self.timer.now>=MAX_SIM_TICKS:
+            self.failure          = 'timeout'
+            self.done()
+
+        if self.uart.txDoneTime!=None and self.uart.txDoneTime<=self.timer.now:
+            self.txDone()
+            self.mote.uart_isr_tx()
+        elif self.uart.rxNextTime!=None and self.uart.rxNextTime<=self.timer.now:
+            self.uart.rxByte      = self.uart.rxBytes.pop(0)
+            if self.uart.rxBytes:
+                self.uart.rxNextTime += self.uart.byteTicks
+            else:
+                self.uart.rxNextTime  = None
+            self.mote.uart_isr_rx()
+        else:
+            self.timer.fireTime   = None
+            self.mote.bsp_timer_isr()
+        return 0
+
+    #======================== wire
+
+    def drainEvents(self):
+        if isinstance(self.uart,NativeUart):
+            self.numEvents       += len(self.mote.drain_events())//EVENT_RECORD_LEN
+
+    def txDone(self):
+        self.drainEvents()
+        buf                       = self.uart.txBuf
+        start                     = self.uart.txStart
+        self.uart.txBuf           = None
+        self.uart.txDoneTime      = None
+        for (i,b) in enumerate(buf):
+            frames                = self.deframer.feed(bytearray([b]))
+            for (frame,wireLen) in zip(frames,self.deframer.wireLens):
+                self.rxFrame(frame,wireLen,start+(i+1)*self.uart.byteTicks)
+        if self.deframer.numBadCrc>0 and self.failure==None:
+            self.failure          = 'bad_crc'
+        if self.uart.now()>=MAX_SIM_TICKS:
+            self.failure          = 'timeout'
+            self.done()
+
+    def rxFrame(self,frame,wireLen,end):
+        if frame[0]==SERFRAME_FRAMING and len(frame)==4:
+            self.framing          = FRAMINGS[frame[3]]
+        if frame[0]!=SERFRAME_DATA or len(frame)<DATA_HEADER_LEN+3:
+            self.numOtherFrames  += 1
+            self.otherWireBytes  += wireLen
+            return
+        payload                   = frame[DATA_HEADER_LEN:]
+        phase                     = payload[0]
+        seq                       = payload[1] | (payload[2]<<8)
+        if phase==PHASE_ECHO:
+            self.rxEcho(seq,end)
+            return
+        stats                     = self.phases[phase]
+        if seq==SEQ_DONE:
+            stats.done            = True
+            stats.wallEnd         = time.time()
+            if phase==len(PHASES)-1:
+                self.sendEcho()
+            return
+        if len(payload)!=PAYLOAD_LEN and self.failure==None:
+            self.failure          = 'payload_len_{0}'.format(len(payload))
+        start                     = end-wireLen*self.uart.byteTicks
+        stats.frame(seq,len(payload),len(frame)+4,wireLen,start,end)
+
+    #======================== echo
+
+    def sendEcho(self):
+        if self.echoSeq==None:
+            self.echoSeq          = 0
+            self.echoWallStart    = time.time()
+        else:
+            self.echoSeq         += 1
+        if self.echoSeq==NUM_ECHOES:
+            self.done()
+        payload                   = [SERFRAME_ECHO,PHASE_ECHO,self.echoSeq&0xff,self.echoSeq>>8]
+        payload                  += [i&0xff for i in range(len(payload)-1,ECHO_LEN)]
+        self.echoSent             = self.uart.send(hdlcify(payload))
+
+    def rxEcho(self,seq,end):
+        if seq!=self.echoSeq:
+            self.failure          = 'echo_seq_{0}_expected_{1}'.format(seq,self.echoSeq)
+            self.done()
+        self.rtts                += [end-self.echoSent]
+        self.sendEcho()
+
+    #======================== end
+
+    def done(self):
+        byteTicks                 = self.uart.byteTicks
+        passed                    = self.failure==None
+        for stats in self.phases:
+            if not stats.done:
+                passed            = False
+                continue
+            print stats.output(byteTicks)
+            if stats.name!='overload' and stats.numFrames!=NUM_FRAMES:
+                passed            = False
+        output                    = []
+        output                   += ['phase=echo']
+        output                   += ['echoes={0}'.format(len(self.rtts))]
+        if self.rtts:
+            toUs                  = 1e6/TICKS_PER_S
+            output               += ['rtt_min_us={0:.1f}'.format(min(self.rtts)*toUs)]
+            output               += ['rtt_avg_us={0:.1f}'.format(sum(self.rtts)/len(self.rtts)*toUs)]
+            output               += ['rtt_max_us={0:.1f}'.format(max(self.rtts)*toUs)]
+            output               += ['rtt_bytes={0:.1f}'.format(sum(self.rtts)/len(self.rtts)/byteTicks)]
+            output               += ['wall_s={0:.3f}'.format(time.time()-self.echoWallStart)]
+        print ' '.join(output)
+        if len(self.rtts)!=NUM_ECHOES:
+            passed                = False
+        if '--cobs' in sys.argv and self.framing!='cobs':
+            passed                = False
+        output                    = []
+        output                   += ['baudrate={0}'.format(int(round(10.0*TICKS_PER_S/byteTicks)))]
+        output                   += ['framing={0}'.format(self.framing)]
+        output                   += ['bsp={0}'.format('native' if isinstance(self.uart,NativeUart) else 'python')]
+        output                   += ['sim_s={0:.3f}'.format(float(self.uart.now())/TICKS_PER_S)]
+        self.drainEvents()
+        output                   += ['notifs={0}'.format(sum(self.mote.get_notif_counts()))]
+        output                   += ['events={0}'.format(self.numEvents)]
+        output                   += ['other_frames={0}'.format(self.numOtherFrames)]
+        output                   += ['other_wire_bytes={0}'.format(self.otherWireBytes)]
+        output                   += ['bad_crc={0}'.format(self.deframer.numBadCrc)]
+        output                   += ['failure={0}'.format(self.failure)]
+        output                   += ['result={0}'.format('PASS' if passed else 'FAIL')]
+        print ' '.join(output)
+        sys.stdout.flush()
+        # mote_main() never returns
+        os._exit(0 if passed else 1)
+
+def hdlcify(buf):
+    crc                           = ~crc16(HDLC_CRCINIT,buf)&0xffff
+    output                        = [HDLC_FLAG]
+    for b in buf+[(crc>>0)&0xff,(crc>>8)&0xff]:
+        if b==HDLC_FLAG or b==HDLC_ESCAPE:
+            output               += [HDLC_ESCAPE,b^HDLC_ESCAPE_MASK]
+        else:
+            output               += [b]
+    output                       += [HDLC_FLAG]
+    return output
+
+#============================ main ============================================
+
+baudrate = BAUDRATE
+if '--baudrate' in sys.argv:
+    baudrate = int(sys.argv[sys.argv.index('--baudrate')+1])
+
+# create instance
+mote  = drv_openserial.OpenMote()
+timer = BspTimer()
+if '--native' in sys.argv:
+    mote.set_native(baudrate)
+    uart  = NativeUart(mote,baudrate)
+else:
+    uart  = Uart(timer,baudrate)
+bench = OpenserialBench(mote,timer,uart)
+
+# install default callback
+for i in range(len(notifString)-1):
+    mote.set_callback(i,lambda *args: None)
+
+# the native BSP modules need no Python, but for the native UART output
+if '--native' in sys.argv:
+    mask = 0
+    for i in range(len(notifString)-1):
+        if not [m for m in NATIVE_MODULES if notifString[i].startswith(m+'_')]:
+            mask |= 1<<i
+    mote.set_subscriptions(mask | 1<<notifId('uart_writeBuffer'))
+    mask = 0
+    for i in range(len(notifString)-1):
+        if [m for m in LOGGED_MODULES if notifString[i].startswith(m+'_')] and \
+           not re.search('_(init|isOn)$',notifString[i]):
+            mask |= 1<<i
+    mote.set_event_log(mask)
+
+# overwrite some callbacks
+mote.set_callback(notifId('eui64_get'),                    lambda: range(8))
+if '--native' in sys.argv:
+    uart.txDone = bench.txDone
+    mote.set_callback(notifId('uart_writeBuffer'),         uart.writeBuffer)
+else:
+    mote.set_callback(notifId('bsp_timer_reset'),          timer.reset)
+    mote.set_callback(notifId('bsp_timer_scheduleIn'),     timer.scheduleIn)
+    mote.set_callback(notifId('bsp_timer_cancel_schedule'),timer.cancel_schedule)
+    mote.set_callback(notifId('bsp_timer_get_currentValue'),timer.get_currentValue)
+    mote.set_callback(notifId('board_sleepFor'),           bench.board_sleepFor)
+    mote.set_callback(notifId('uart_writeByte'),           uart.writeByte)
+    mote.set_callback(notifId('uart_writeBuffer'),         uart.writeBuffer)
+    mote.set_callback(notifId('uart_readByte'),            uart.readByte)
+
+if '--cobs' in sys.argv:
+    bench.setFraming('cobs')
+
+# start the mote
+mote.supply_on()
@@ -0,0 +1,211 @@
+'''
+Decoder of the opentrace records a mote prints over serial.
+
+Reads the raw serial bytes, from a file, a serial port or stdin, finds the HDLC
+or COBS frames, and decodes the records of the trace frames ('T') among them; the
+other frames are skipped. Each record is 4 bytes: event, 16-bit little-endian
+radiotimer timestamp, argument (see drivers/common/opentrace.h). Motes only
+print trace frames if built with OPENTRACE_ENABLED.
+
+Usage:
+   python opentrace_decode.py [file]
+   python opentrace_decode.py --port /dev/ttyUSB0 [--baudrate 115200]
+
+Prints one "key=value" line per record; timestamps are unwrapped into a
+monotonic tick count. The last line sums up the frames and records decoded.
+'''
+
+import sys
+
+HDLC_FLAG          = 0x7e
+HDLC_ESCAPE        = 0x7d
+HDLC_ESCAPE_MASK   = 0x20
+HDLC_CRCINIT       = 0xffff
+HDLC_CRCGOOD       = 0xf0b8
+COBS_DELIMITER     = 0x00
+COBS_MAX_CODE      = 0xff
+
+SERFRAME_TRACE     = ord('T')
+RECORD_LEN         = 4
+
+# OPENTRACE_EVENT_* in opentrace.h
+EVENT_NAMES = {
+    0x00: 'DROPPED',
+    0x01: 'TIMER_FIRED',
+    0x02: 'TASK_RUN',
+}
+EVENT_STACK        = 0x10
+
+#============================ helpers =========================================
+
+def crc16(crc, data):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            if crc & 1:
+                crc = (crc >> 1) ^ 0x8408
+            else:
+                crc >>= 1
+    return crc
+
+def eventName(event):
+    if event in EVENT_NAMES:
+        return EVENT_NAMES[event]
+    if event >= EVENT_STACK:
+        return 'STACK+{0}'.format(event-EVENT_STACK)
+    return 'UNKNOWN_0x{0:02x}'.format(event)
+
+class Deframer(object):
+    '''
+    Turns a byte stream into the frames it holds, CRC checked and removed.
+
+    Frames are HDLC frames, or COBS frames once the mote was asked for them
+    (see SERIAL_COBS in openserial.h); the first byte of a frame, HDLC_FLAG or
+    COBS_DELIMITER, tells which. wireLens holds the number of bytes on the wire
+    of each frame the last feed() returned, delimiters included.
+    '''
+
+    def __init__(self):
+        self.framing       = None   # framing of the frame being received, if any
+        self.frame         = bytearray()
+        self.escaping      = False
+        self.wireLen       = 0
+        self.wireLens      = []
+        self.numBadCrc     = 0
+
+    def feed(self, data):
+        frames             = []
+        self.wireLens      = []
+        for b in bytearray(data):
+            self.wireLen  += 1
+            if self.framing == 'hdlc':
+                if b == HDLC_FLAG:
+                    if len(self.frame) > 0:
+                        self.end(frames)
+                    # a closing flag may also open the next frame
+                    self.start('hdlc')
+                elif b == COBS_DELIMITER and len(self.frame) == 0 and not self.escaping:
+                    self.start('cobs')
+                elif b == HDLC_ESCAPE:
+                    self.escaping = True
+                else:
+                    if self.escaping:
+                        b ^= HDLC_ESCAPE_MASK
+                        self.escaping = False
+                    self.frame.append(b)
+            elif self.framing == 'cobs':
+                if b == COBS_DELIMITER:
+                    if len(self.frame) > 0:
+                        self.frame = cobsDecode(self.frame)
+                        self.end(frames)
+                        self.framing = None
+                    else:
+                        self.start('cobs')
+                else:
+                    self.frame.append(b)
+            elif b == HDLC_FLAG:
+                self.start('hdlc')
+            elif b == COBS_DELIMITER:
+                self.start('cobs')
+            else:
+                self.wireLen  = 0
+        return frames
+
+    def start(self, framing):
+        self.framing       = framing
+        self.frame         = bytearray()
+        self.escaping      = False
+        self.wireLen       = 1
+
+    def end(self, frames):
+        if self.frame is not None and len(self.frame) > 2 and crc16(HDLC_CRCINIT, self.frame) == HDLC_CRCGOOD:
+            frames.append(self.frame[:-2])
+            self.wireLens.append(self.wireLen)
+        else:
+            self.numBadCrc += 1
+
+def cobsDecode(data):
+    '''
+    Returns the COBS decoded frame, None if the code bytes are inconsistent.
+    '''
+    output                 = bytearray()
+    i                      = 0
+    while i < len(data):
+        code               = data[i]
+        if code == 0 or i+code > len(data):
+            return None
+        output            += data[i+1:i+code]
+        i                 += code
+        if code < COBS_MAX_CODE and i < len(data):
+            output.append(0)
+    return output
+
+class TraceDecoder(object):
+    '''
+    Decodes trace frames into records with unwrapped timestamps.
+    '''
+
+    def __init__(self):
+        self.lastTimestamp = None
+        self.ticks         = 0
+        self.numFrames     = 0
+        self.numRecords    = 0
+        self.numDropped    = 0
+
+    def decode(self, frame):
+        if len(frame) < 3 or frame[0] != SERFRAME_TRACE:
+            return []
+        self.numFrames += 1
+        moteId  = (frame[1] << 8) | frame[2]
+        payload = frame[3:]
+        records = []
+        for i in range(0, len(payload)-RECORD_LEN+1, RECORD_LEN):
+            event     = payload[i]
+            timestamp = payload[i+1] | (payload[i+2] << 8)
+            arg       = payload[i+3]
+            if self.lastTimestamp is not None:
+                self.ticks += (timestamp-self.lastTimestamp) & 0xffff
+            self.lastTimestamp = timestamp
+            if event == 0x00:
+                self.numDropped += arg
+            self.numRecords += 1
+            records.append((moteId, self.ticks, timestamp, event, arg))
+        return records
+
+#============================ main ============================================
+
+def openInput(argv):
+    if '--port' in argv:
+        import serial
+        port     = argv[argv.index('--port')+1]
+        baudrate = 115200
+        if '--baudrate' in argv:
+            baudrate = int(argv[argv.index('--baudrate')+1])
+        return serial.Serial(port, baudrate, timeout=1)
+    if len(argv) > 1:
+        return open(argv[1], 'rb')
+    return getattr(sys.stdin, 'buffer', sys.stdin)
+
+def main(argv):
+    inp      = openInput(argv)
+    deframer = Deframer()
+    decoder  = TraceDecoder()
+    try:
+        while True:
+            data = inp.read(256)
+            if not data:
+                if '--port' in argv:
+                    continue
+                break
+            for frame in deframer.feed(data):
+                for (moteId, ticks, timestamp, event, arg) in decoder.decode(frame):
+                    print('mote=0x{0:04x} ticks={1} timestamp={2} event={3} arg={4}'.format(
+                        moteId, ticks, timestamp, eventName(event), arg))
+    except KeyboardInterrupt:
+        pass
+    print('frames={0} records={1} dropped={2} bad_crc={3}'.format(
+        decoder.numFrames, decoder.numRecords, decoder.numDropped, deframer.numBadCrc))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,146 @@
+'''
+Long-run phase test of periodic opentimers on the python board.
+
+Runs the 02drv_opentimers_drift project for NUM_PERIODS periods on an emulated
+telosb-like bsp_timer (16-bit counter, compare relative to the previous one),
+adding a random interrupt latency to every compare. The time of every toggle of
+the error LED is compared to the first one plus a whole number of periods.
+
+Build the module first:
+   scons board=python toolchain=gcc drv_opentimers_drift
+
+Prints one "key=value" line, and exits with 0 iff the phase error never
+exceeded twice the maximum interrupt latency.
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains the module
+
+import re
+import random
+
+NUM_PERIODS        = 1000000
+PERIOD_TICKS       = 1000       # APP_PERIOD_TICKS in 02drv_opentimers_drift.c
+MAX_LATENCY_TICKS  = 20
+COUNTER_MAX        = 0x10000
+
+#============================ get notification IDs ============================
+
+f = open(os.path.join('..','..','bsp','boards','python','openwsnmodule_obj.h'))
+lines = f.readlines()
+f.close()
+
+notifString = []
+
+for line in lines:
+    m = re.search('MOTE_NOTIF_(\w+)',line)
+    if m:
+        if m.group(1) not in notifString:
+            notifString += [m.group(1)]
+
+def notifId(s):
+    assert s in notifString
+    return notifString.index(s)
+
+import drv_opentimers_drift
+
+#============================ emulated bsp_timer ==============================
+
+class BspTimer(object):
+    
+    def __init__(self):
+        self.now                  = 0   # absolute simulated time, in ticks
+        self.resetTime            = 0
+        self.lastCompare          = 0
+        self.fireTime             = None
+    
+    def counter(self):
+        return (self.now-self.resetTime)%COUNTER_MAX
+    
+    def reset(self):
+        self.resetTime            = self.now
+        self.lastCompare          = 0
+        self.fireTime             = None
+    
+    def scheduleIn(self,delay):
+        elapsed                   = (self.counter()-self.lastCompare)%COUNTER_MAX
+        self.lastCompare          = (self.lastCompare+delay)%COUNTER_MAX
+        if delay<=elapsed:
+            # too late, fires right away
+            self.fireTime         = self.now
+        else:
+            self.fireTime         = self.now+(self.lastCompare-self.counter())%COUNTER_MAX
+    
+    def cancel_schedule(self):
+        self.fireTime             = None
+    
+    def get_currentValue(self):
+        return self.counter()
+
+#============================ test ============================================
+
+class DriftTest(object):
+    
+    def __init__(self,mote,timer):
+        self.mote                 = mote
+        self.timer                = timer
+        self.numPeriods           = 0
+        self.firstToggle          = None
+        self.maxError             = 0
+        self.lastError            = 0
+    
+    def board_sleep(self):
+        assert self.timer.fireTime!=None
+        self.timer.now            = self.timer.fireTime+random.randint(0,MAX_LATENCY_TICKS)
+        self.timer.fireTime       = None
+        self.mote.bsp_timer_isr()
+    
+    def leds_error_toggle(self):
+        if self.firstToggle==None:
+            self.firstToggle      = self.timer.now
+        else:
+            self.lastError        = self.timer.now-self.firstToggle-self.numPeriods*PERIOD_TICKS
+            self.maxError         = max(self.maxError,abs(self.lastError))
+        self.numPeriods          += 1
+        if self.numPeriods==NUM_PERIODS:
+            self.done()
+    
+    def done(self):
+        passed = self.maxError<=2*MAX_LATENCY_TICKS
+        print 'periods={0} period_ticks={1} max_latency_ticks={2} max_error_ticks={3} final_error_ticks={4} result={5}'.format(
+            self.numPeriods,
+            PERIOD_TICKS,
+            MAX_LATENCY_TICKS,
+            self.maxError,
+            self.lastError,
+            'PASS' if passed else 'FAIL',
+        )
+        sys.stdout.flush()
+        # mote_main() never returns
+        os._exit(0 if passed else 1)
+
+# create instance
+mote  = drv_opentimers_drift.OpenMote()
+timer = BspTimer()
+test  = DriftTest(mote,timer)
+
+# install default callback
+for i in range(len(notifString)-1):
+    mote.set_callback(i,lambda *args: None)
+
+# overwrite some callbacks
+mote.set_callback(notifId('eui64_get'),                    lambda: range(8))
+mote.set_callback(notifId('bsp_timer_reset'),              timer.reset)
+mote.set_callback(notifId('bsp_timer_scheduleIn'),         timer.scheduleIn)
+mote.set_callback(notifId('bsp_timer_cancel_schedule'),    timer.cancel_schedule)
+mote.set_callback(notifId('bsp_timer_get_currentValue'),   timer.get_currentValue)
+mote.set_callback(notifId('board_sleep'),                  test.board_sleep)
+mote.set_callback(notifId('leds_error_toggle'),            test.leds_error_toggle)
+
+random.seed(0)
+
+# start the mote
+mote.supply_on()
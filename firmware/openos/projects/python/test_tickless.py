@@ -0,0 +1,196 @@
+'''
+Tickless idle test of the scheduler on the python board.
+
+Runs the 03oos_tickless project on an emulated telosb-like bsp_timer (16-bit
+counter, compare relative to the previous one). When the scheduler has nothing
+to do, board_sleepFor() either:
+- sleeps deeply for the ticks it is given, with the counter stopped, and
+  returns them so opentimers compensates for them, or
+- sleeps lightly until the compare interrupt, after a random latency, and
+  returns 0, as boards whose counter keeps running do.
+Every wake-up costs a random number of ticks awake before sleeping again.
+
+The time of every LED toggle is compared to its timer's n-th expiry. Build the
+module first:
+   scons board=python toolchain=gcc oos_tickless
+
+Prints one "key=value" line, and exits with 0 iff every timer fired on time,
+and the emulated mote spent most of its time in deep sleep.
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains the module
+
+import re
+import random
+
+SIM_TICKS          = 100000000
+MAX_LATENCY_TICKS  = 20         # light sleep wake-up, and time awake
+DEEP_SLEEP_PROB    = 0.9
+MIN_SLEEP_RATIO    = 0.5
+COUNTER_MAX        = 0x10000
+
+# as in 03oos_tickless.c: LED -> (period, slack)
+TIMERS = {
+    'error':    (1000,    0),
+    'radio':    (100000,  0),
+    'sync':     (3000,  500),
+}
+
+#============================ get notification IDs ============================
+
+f = open(os.path.join('..','..','bsp','boards','python','openwsnmodule_obj.h'))
+lines = f.readlines()
+f.close()
+
+notifString = []
+
+for line in lines:
+    m = re.search('MOTE_NOTIF_(\w+)',line)
+    if m:
+        if m.group(1) not in notifString:
+            notifString += [m.group(1)]
+
+def notifId(s):
+    assert s in notifString
+    return notifString.index(s)
+
+import oos_tickless
+
+#============================ emulated bsp_timer ==============================
+
+class BspTimer(object):
+
+    def __init__(self):
+        self.now                  = 0   # absolute simulated time, in ticks
+        self.resetTime            = 0
+        self.lastCompare          = 0
+        self.fireTime             = None
+
+    def counter(self):
+        return (self.now-self.resetTime)%COUNTER_MAX
+
+    def reset(self):
+        self.resetTime            = self.now
+        self.lastCompare          = 0
+        self.fireTime             = None
+
+    def scheduleIn(self,delay):
+        elapsed                   = (self.counter()-self.lastCompare)%COUNTER_MAX
+        self.lastCompare          = (self.lastCompare+delay)%COUNTER_MAX
+        if delay<=elapsed:
+            # too late, fires right away
+            self.fireTime         = self.now
+        else:
+            self.fireTime         = self.now+(self.lastCompare-self.counter())%COUNTER_MAX
+
+    def cancel_schedule(self):
+        self.fireTime             = None
+
+    def get_currentValue(self):
+        return self.counter()
+
+    def stop(self,ticks):
+        # time passes, the counter does not
+        self.now                 += ticks
+        self.resetTime           += ticks
+        if self.fireTime!=None:
+            self.fireTime        += ticks
+
+#============================ test ============================================
+
+class TicklessTest(object):
+
+    def __init__(self,mote,timer):
+        self.mote                 = mote
+        self.timer                = timer
+        self.numToggles           = dict([(led,0) for led in TIMERS])
+        self.maxLateness          = dict([(led,0) for led in TIMERS])
+        self.numWakeups           = 0
+        self.deepSleepTicks       = 0
+        self.lightSleepTicks      = 0
+        self.failure              = None
+
+    def board_sleepFor(self,maxTicks):
+        self.numWakeups          += 1
+
+        # time spent awake since the previous wake-up
+        self.timer.now           += random.randint(0,MAX_LATENCY_TICKS)
+        if self.timer.now>=SIM_TICKS:
+            self.done()
+
+        if self.timer.fireTime!=None and self.timer.fireTime<=self.timer.now:
+            # interrupt pending, no sleep
+            self.timer.fireTime   = None
+            self.mote.bsp_timer_isr()
+            return 0
+
+        if random.random()<DEEP_SLEEP_PROB:
+            assert maxTicks!=0xffffffff
+            self.timer.stop(maxTicks)
+            self.deepSleepTicks  += maxTicks
+            return maxTicks
+        else:
+            assert self.timer.fireTime!=None
+            wakeTime              = self.timer.fireTime+random.randint(0,MAX_LATENCY_TICKS)
+            self.lightSleepTicks += wakeTime-self.timer.now
+            self.timer.now        = wakeTime
+            self.timer.fireTime   = None
+            self.mote.bsp_timer_isr()
+            return 0
+
+    def toggle(self,led):
+        (period,slack)            = TIMERS[led]
+        self.numToggles[led]     += 1
+        lateness                  = self.timer.now-self.numToggles[led]*period
+        self.maxLateness[led]     = max(self.maxLateness[led],lateness)
+        if lateness<0 or lateness>slack+2*MAX_LATENCY_TICKS:
+            self.failure          = '{0}_toggle_{1}_lateness_{2}'.format(led,self.numToggles[led],lateness)
+            self.done()
+
+    def done(self):
+        sleepRatio = float(self.deepSleepTicks)/self.timer.now
+        passed     = self.failure==None and sleepRatio>=MIN_SLEEP_RATIO
+        output     = []
+        output    += ['ticks={0}'.format(self.timer.now)]
+        output    += ['wakeups={0}'.format(self.numWakeups)]
+        output    += ['deep_sleep_ticks={0}'.format(self.deepSleepTicks)]
+        output    += ['light_sleep_ticks={0}'.format(self.lightSleepTicks)]
+        output    += ['sleep_ratio={0:.4f}'.format(sleepRatio)]
+        for led in sorted(TIMERS):
+            output += ['{0}_toggles={1}'.format(led,self.numToggles[led])]
+            output += ['{0}_max_lateness_ticks={1}'.format(led,self.maxLateness[led])]
+        output    += ['failure={0}'.format(self.failure)]
+        output    += ['result={0}'.format('PASS' if passed else 'FAIL')]
+        print ' '.join(output)
+        sys.stdout.flush()
+        # mote_main() never returns
+        os._exit(0 if passed else 1)
+
+# create instance
+mote  = oos_tickless.OpenMote()
+timer = BspTimer()
+test  = TicklessTest(mote,timer)
+
+# install default callback
+for i in range(len(notifString)-1):
+    mote.set_callback(i,lambda *args: None)
+
+# overwrite some callbacks
+mote.set_callback(notifId('eui64_get'),                    lambda: range(8))
+mote.set_callback(notifId('bsp_timer_reset'),              timer.reset)
+mote.set_callback(notifId('bsp_timer_scheduleIn'),         timer.scheduleIn)
+mote.set_callback(notifId('bsp_timer_cancel_schedule'),    timer.cancel_schedule)
+mote.set_callback(notifId('bsp_timer_get_currentValue'),   timer.get_currentValue)
+mote.set_callback(notifId('board_sleepFor'),               test.board_sleepFor)
+mote.set_callback(notifId('leds_error_toggle'),            lambda: test.toggle('error'))
+mote.set_callback(notifId('leds_radio_toggle'),            lambda: test.toggle('radio'))
+mote.set_callback(notifId('leds_sync_toggle'),             lambda: test.toggle('sync'))
+
+random.seed(0)
+
+# start the mote
+mote.supply_on()